@@ -0,0 +1,114 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+/*
+ * bench_format: fixed-width decimal formatting used by the ISO writer.
+ * Compares the sprintf based conversion that longtostrn used to do with
+ * strutils::formatDecimal, on directory-like values (4 digit lengths,
+ * 5 digit offsets).
+ *
+ *   make bench
+ */
+
+#include	<cstdio>
+#include	<cstdlib>
+#include	<cstring>
+#include	<ctime>
+
+#include	"strutils.h"
+
+
+#define NVALUES		4096
+#define ROUNDS		2000
+
+
+// the previous longtostrn, without the error report //
+static int sprintfFormat( char *offs, long lv, int len )
+{
+   char cnvl[24];
+   sprintf(cnvl, "%0*ld", len, lv);
+   if ((int) strlen(cnvl) > len)
+      return 0;
+   memcpy(offs, cnvl, len);
+   return 1;
+}
+
+
+static double now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+typedef int (*formatfn)( char*, long, int );
+
+static double run( formatfn fn, const long *lens, const long *offs, char *out )
+{
+   double t0 = now();
+   for (int r = 0 ; r < ROUNDS ; ++r)
+   {
+      char *dp = out;
+      for (int j = 0 ; j < NVALUES ; ++j)
+      {
+         fn(dp, lens[j], 4);
+         fn(dp + 4, offs[j], 5);
+         dp += 9;
+      }
+   }
+   return (now() - t0) * 1e9 / ((double) ROUNDS * NVALUES * 2);
+}
+
+
+int main()
+{
+   static long lens[NVALUES], offs[NVALUES];
+   static char out1[NVALUES * 9], out2[NVALUES * 9];
+   long pos = 0;
+
+   srand(2709);
+   for (int j = 0 ; j < NVALUES ; ++j)
+   {
+      lens[j] = 1 + rand() % 400;
+      offs[j] = pos % 100000;
+      pos += lens[j];
+   }
+
+   double ts = run(sprintfFormat, lens, offs, out1);
+   double tf = run(strutils::formatDecimal, lens, offs, out2);
+
+   if (memcmp(out1, out2, sizeof(out1)) != 0)
+   {
+      fprintf(stderr, "bench_format: results differ\n");
+      return 1;
+   }
+   printf("sprintf       %6.1f ns/number\n", ts);
+   printf("formatDecimal %6.1f ns/number\n", tf);
+   printf("speedup       %6.1fx\n", ts / tf);
+   return 0;
+}
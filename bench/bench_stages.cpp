@@ -0,0 +1,246 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+/*
+ * bench_stages: throughput of each stage of the conversion on a corpus
+ * (e.g. one written by gen_corpus), in records/s and MB/s of input:
+ *   framing         find the end of each record (RT)
+ *   delimiter scan  collect the RT/FT/SF positions of a framed record
+ *   directory       label and directory decoding (parse with -f 001)
+ *   parse           delimiter scan, directory and field location
+ *   subfields       building all the fields of a parsed record
+ *   XML, text, ISO  serialization of the built record to memory (ISO
+ *                   copies unmodified records as they are)
+ *   visitor         label, directory and subfield events of a RecordVisitor
+ * Each stage is timed directly around its own calls, record by record, in
+ * a pass that does the preceding steps untimed; each pass is repeated and
+ * the fastest one is kept.  "read + XML" is the whole XML pass.
+ *
+ *   bench_stages [-r repeats] corpus.mrc
+ *   make bench
+ */
+
+#include	<cstdio>
+#include	<cstdlib>
+#include	<cstring>
+#include	<ctime>
+#include	<vector>
+
+#include	"RecordIso2709.h"
+#include	"RecordReader.h"
+#include	"FieldFilter.h"
+#include	"OutSink.h"
+#include	"RecordVisitor.h"
+#include	"scanutils.h"
+
+
+enum { FRAME, SCAN, DIRECTORY, PARSE, SUBFIELDS, XML, TEXT, ISO, VISIT, NPASSES };
+
+
+static double now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+// counts the subfields, so that the events are not optimized away //
+class CountVisitor : public RecordVisitor
+{
+  public:
+	long	nsubfields;
+	CountVisitor() : nsubfields(0) {}
+	void	subField( char, const char *, int ) { ++nsubfields; }
+};
+
+
+// builds all the fields of the parsed record //
+static void buildFields( RecordIso2709 &rec )
+{
+   int n = rec.getFieldCount();
+   for (int j = 0 ; j < n ; ++j)
+      rec.getField(j);
+}
+
+
+//---------------------------------------------------------------------------------
+// pass(const char*, int, long&, double&)
+//
+// one pass over the corpus: returns the seconds spent in stage 'what',
+// and in 'total' those of the whole pass; counts the records
+//---------------------------------------------------------------------------------
+
+static double pass( const char *path, int what, long &nrecs, double &total )
+{
+   RecordReader  input;
+   RecordIso2709 rec;
+   FieldFilter   only001;
+   OutSink       mem;
+   CountVisitor  counter;
+   std::vector<char*> delims;
+   char  *rp;
+   long  len;
+   double t, secs = 0;
+
+   if (! input.open(path) || ! input.isMapped())
+   {
+      fprintf(stderr, "bench_stages: cannot map %s\n", path);
+      exit(1);
+   }
+   only001.parse("001");
+   if (what == DIRECTORY)
+      rec.setFieldFilter(&only001);
+
+   nrecs = 0;
+   double t0 = now();
+   if (what == FRAME)
+   {
+      while (input.next(rp, len))
+         ++nrecs;
+      total = now() - t0;
+      return total;
+   }
+
+   while (input.next(rp, len))
+   {
+      ++nrecs;
+      switch (what)
+      {
+         case SCAN:
+                  t = now();
+                  scanutils::scanDelimiters(rp, len, delims);
+                  secs += now() - t;
+                  delims.clear();
+                  continue;
+         case VISIT:
+                  t = now();
+                  counter.visit(rp, len);
+                  secs += now() - t;
+                  continue;
+         case DIRECTORY:
+         case PARSE:
+                  t = now();
+                  rec.clear();
+                  rec.parse(rp, len);
+                  secs += now() - t;
+                  continue;
+      }
+
+      rec.clear();
+      rec.parse(rp, len);
+      if (what == SUBFIELDS)
+      {
+         t = now();
+         buildFields(rec);
+         secs += now() - t;
+         continue;
+      }
+      buildFields(rec);
+      t = now();
+      if (what == XML)
+         rec.printXML(mem, 0);
+      else
+      if (what == TEXT)
+         rec.print(mem);
+      else
+         rec.write_iso(mem);
+      secs += now() - t;
+      mem.clear();
+   }
+   total = now() - t0;
+   return secs;
+}
+
+
+static void report( const char *name, double secs, long nrecs, long bytes )
+{
+   if (secs <= 0)
+   {
+      printf("%-16s %10s       %10s      %9s\n", name, "n/a", "n/a", "n/a");
+      return;
+   }
+   printf("%-16s %10.0f rec/s %10.1f MB/s %9.3f s\n",
+          name, nrecs / secs, bytes / secs / 1e6, secs);
+}
+
+
+int main( int argc, char **argv )
+{
+   int repeats = 3;
+   int cnt = 1;
+
+   if ((argc > 2) && (strcmp(argv[1], "-r") == 0))
+   {
+      repeats = atoi(argv[2]);
+      cnt = 3;
+   }
+   if ((cnt != argc - 1) || (repeats < 1))
+   {
+      fprintf(stderr, "usage: bench_stages [-r repeats] corpus.mrc\n");
+      return 2;
+   }
+
+   RecordReader probe;
+   if (! probe.open(argv[cnt]))
+   {
+      fprintf(stderr, "bench_stages: cannot open %s\n", argv[cnt]);
+      return 1;
+   }
+   long bytes = probe.getSize();
+   probe.close();
+
+   double best[NPASSES];
+   double xmltotal = 1e30;
+   long   nrecs = 0;
+   for (int w = 0 ; w < NPASSES ; ++w)
+   {
+      best[w] = 1e30;
+      for (int r = 0 ; r < repeats ; ++r)
+      {
+         double total;
+         double t = pass(argv[cnt], w, nrecs, total);
+         if (t < best[w])
+            best[w] = t;
+         if ((w == XML) && (total < xmltotal))
+            xmltotal = total;
+      }
+   }
+
+   printf("corpus: %s, %ld records, %.1f MB\n", argv[cnt], nrecs, bytes / 1e6);
+   report("framing",        best[FRAME], nrecs, bytes);
+   report("delimiter scan", best[SCAN], nrecs, bytes);
+   report("directory",      best[DIRECTORY], nrecs, bytes);
+   report("parse",          best[PARSE], nrecs, bytes);
+   report("subfields",      best[SUBFIELDS], nrecs, bytes);
+   report("XML",            best[XML], nrecs, bytes);
+   report("text",           best[TEXT], nrecs, bytes);
+   report("ISO",            best[ISO], nrecs, bytes);
+   report("visitor",        best[VISIT], nrecs, bytes);
+   report("read + XML",     xmltotal, nrecs, bytes);
+   return 0;
+}
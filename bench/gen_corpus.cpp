@@ -0,0 +1,316 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+/*
+ * gen_corpus: writes a synthetic UNIMARC corpus (ISO 2709) for the
+ * benchmarks.  Records have a 4/5 directory entry map, control fields
+ * 001/005, a configurable number of data fields drawn from a typical
+ * bibliographic mix, optional embedded 4XX fields ($1) and a share of
+ * large records (many 960 holdings fields) up to the 5 digit record
+ * length limit.  The text contains accented UTF-8 letters and, now and
+ * then, characters that XML must escape.
+ *
+ *   gen_corpus [-n records] [-f min,max] [-e percent] [-l percent]
+ *              [-z size] [-s seed] output-file
+ *
+ *   -n : number of records (default 100000)
+ *   -f : data fields per record, besides the holdings (default 8,30)
+ *   -e : percent of records with embedded 4XX fields (default 30)
+ *   -l : percent of large records (default 2)
+ *   -z : size of the largest records in bytes (default 99999, the most
+ *        a 5 digit record length allows; MAXRECSIZE is larger)
+ *   -s : random seed (default 2709)
+ */
+
+#include	<algorithm>
+#include	<cstdio>
+#include	<cstdlib>
+#include	<cstring>
+#include	<string>
+#include	<vector>
+
+#include	"RecordIso2709.h"
+
+
+#define MAXRECLEN	99999		// 5 digit record length //
+#define MAXFIELDLEN	9999		// 4 digit field length //
+
+
+static const char *words[] =
+{
+   "storia", "d'Italia", "annali", "della", "letteratura", "italiana", "il", "la",
+   "Firenze", "Torino", "Einaudi", "Laterza", "Mondadori", "biblioteca", "nazionale",
+   "centrale", "catalogo", "edizioni", "volume", "raccolta", "poesie", "romanzo",
+   "città", "perché", "Niccolò", "società", "università", "però", "più", "libertà",
+   "scienza", "tecnica", "cultura", "dal", "Rinascimento", "a", "oggi", "manuale",
+   "introduzione", "studi", "saggi", "lettere", "opere", "complete", "commento",
+   "Dante", "Petrarca", "Boccaccio", "Machiavelli", "Galilei", "Manzoni", "Leopardi",
+   "Verga", "Pirandello", "Calvino", "Eco", "\"Il", "nome", "della", "rosa\"",
+   "R&D", "<sic>", "et", "al."
+};
+#define NWORDS	((int) (sizeof(words) / sizeof(words[0])))
+
+
+static int rnd( int n )
+{
+   return rand() % n;
+}
+
+
+static void addWords( std::string &s, int n )
+{
+   for (int j = 0 ; j < n ; ++j)
+   {
+      if (j > 0)
+         s += ' ';
+      s += words[rnd(NWORDS)];
+   }
+}
+
+
+static void addDigits( std::string &s, int n )
+{
+   for (int j = 0 ; j < n ; ++j)
+      s += (char) ('0' + rnd(10));
+}
+
+
+// data field: indicators, then code/value pairs //
+static std::string dataField( const char *ind, const char *codes, int maxwords )
+{
+   std::string f(ind, 2);
+   for (const char *cp = codes ; *cp ; ++cp)
+   {
+      f += (char) SF;
+      f += *cp;
+      addWords(f, 1 + rnd(maxwords));
+   }
+   return f;
+}
+
+
+struct FieldData
+{
+   char		tag[4];
+   std::string	data;
+};
+
+
+static void add( std::vector<FieldData> &flds, const char *tag, const std::string &data )
+{
+   FieldData fd;
+   memcpy(fd.tag, tag, 4);
+   fd.data = data;
+   if ((int) fd.data.size() >= MAXFIELDLEN)
+      fd.data.resize(MAXFIELDLEN - 1);
+   flds.push_back(fd);
+}
+
+
+// an embedded 4XX field: $1 + tag + data of each embedded field //
+static std::string embeddedField( long recno )
+{
+   std::string f("  ");
+   char id[16];
+
+   snprintf(id, sizeof(id), "CFI%07ld", (recno * 7919) % 10000000);
+   f += (char) SF;
+   f += "1001";
+   f += id;
+   f += (char) SF;
+   f += "1200";
+   f += dataField("1 ", "afv", 6);
+   return f;
+}
+
+
+static void buildFields( std::vector<FieldData> &flds, long recno, int nfields, int embedded, long target )
+{
+   static const char *mix[][3] =
+   {
+      // tag, indicators, subfield codes //
+      { "010", "  ", "ab" },  { "100", "  ", "a" },   { "101", "| ", "a" },
+      { "102", "  ", "a" },   { "200", "1 ", "aefg" },{ "210", "  ", "acd" },
+      { "215", "  ", "ad" },  { "225", "| ", "av" },  { "300", "  ", "a" },
+      { "410", " 1", "a" },   { "606", "  ", "ax23" },{ "676", "  ", "av9" },
+      { "700", " 1", "ab34" },{ "701", " 1", "ab34" },{ "702", " 1", "ab34" },
+      { "712", "02", "a34" }, { "801", " 3", "abc" }, { "850", "  ", "aaa" }
+   };
+   const int nmix = sizeof(mix) / sizeof(mix[0]);
+   char buf[32];
+
+   snprintf(buf, sizeof(buf), "BEN%07ld", recno);
+   add(flds, "001", buf);
+   std::string ts;
+   addDigits(ts, 14);
+   add(flds, "005", ts + ".0");
+
+   // (tag, mix entry or -1 for an embedded field), sorted by tag as //
+   // directories normally are //
+   std::vector<std::pair<int,int> > picks;
+   for (int j = 0 ; j < nfields ; ++j)
+   {
+      int m = rnd(nmix);
+      picks.push_back(std::make_pair(atoi(mix[m][0]), m));
+   }
+   if (embedded)
+      picks.push_back(std::make_pair(461 + rnd(3), -1));
+   std::sort(picks.begin(), picks.end());
+
+   for (size_t j = 0 ; j < picks.size() ; ++j)
+   {
+      int m = picks[j].second;
+      if (m < 0)
+      {
+         snprintf(buf, sizeof(buf), "%03d", picks[j].first);
+         add(flds, buf, embeddedField(recno + j));
+      }
+      else
+         add(flds, mix[m][0], dataField(mix[m][1], mix[m][2], 5));
+   }
+
+   // holdings: at least one, many for the large records //
+   long size = 24 + 1 + 1;
+   for (size_t j = 0 ; j < flds.size() ; ++j)
+      size += 12 + flds[j].data.size() + 1;
+   do
+   {
+      std::string h = dataField(" 1", "abcd", 8);
+      if (size + 12 + (long) h.size() + 1 > target)
+         break;
+      add(flds, "960", h);
+      size += 12 + h.size() + 1;
+   }
+   while (size < target);
+}
+
+
+// label, directory, fields, RT; "" if it does not fit the limits //
+static std::string buildRecord( const std::vector<FieldData> &flds, int level )
+{
+   long base = 24 + 12 * flds.size() + 1;
+   long dlen = 0;
+   for (size_t j = 0 ; j < flds.size() ; ++j)
+      dlen += flds[j].data.size() + 1;
+   long total = base + dlen + 1;
+   if ((total > MAXRECLEN) || (total > MAXRECSIZE))
+      return "";
+
+   // sized for any long: the limits above keep the numbers to 5 digits //
+   char label[64];
+   snprintf(label, sizeof(label), "%05ldna%c0 22%05ld i 450 ", total, level, base);
+   std::string rec(label, 24);
+
+   long offs = 0;
+   for (size_t j = 0 ; j < flds.size() ; ++j)
+   {
+      char entry[64];
+      snprintf(entry, sizeof(entry), "%s%04ld%05ld", flds[j].tag, (long) flds[j].data.size() + 1, offs);
+      rec.append(entry, 12);
+      offs += flds[j].data.size() + 1;
+   }
+   rec += (char) FT;
+   for (size_t j = 0 ; j < flds.size() ; ++j)
+   {
+      rec += flds[j].data;
+      rec += (char) FT;
+   }
+   rec += (char) RT;
+   return rec;
+}
+
+
+static void usage()
+{
+   fprintf(stderr, "usage: gen_corpus [-n records] [-f min,max] [-e percent] [-l percent] [-z size] [-s seed] output-file\n");
+   exit(2);
+}
+
+
+int main( int argc, char **argv )
+{
+   long nrecs = 100000;
+   int  fmin = 8, fmax = 30;
+   int  pembedded = 30;
+   int  plarge = 2;
+   long maxsize = MAXRECLEN;
+   unsigned seed = 2709;
+   int  cnt = 1;
+
+   for ( ; (cnt < argc - 1) && (argv[cnt][0] == '-') ; cnt += 2)
+   {
+      const char *val = argv[cnt+1];
+      switch (argv[cnt][1])
+      {
+         case 'n': nrecs = atol(val); break;
+         case 'f': if (sscanf(val, "%d,%d", &fmin, &fmax) != 2) usage(); break;
+         case 'e': pembedded = atoi(val); break;
+         case 'l': plarge = atoi(val); break;
+         case 'z': maxsize = atol(val); break;
+         case 's': seed = atoi(val); break;
+         default:  usage();
+      }
+   }
+   // an option left over (e.g. a lone -h) is not an output-file //
+   if ((cnt != argc - 1) || (argv[cnt][0] == '-'))
+      usage();
+   if ((nrecs < 0) || (fmin < 0) || (fmax < fmin) || (maxsize < 1000))
+      usage();
+   if (maxsize > MAXRECLEN)
+      maxsize = MAXRECLEN;
+
+   FILE *fp = fopen(argv[cnt], "wb");
+   if (fp == NULL)
+   {
+      perror(argv[cnt]);
+      return 1;
+   }
+   srand(seed);
+
+   long bytes = 0;
+   for (long n = 0 ; n < nrecs ; ++n)
+   {
+      static const char levels[] = "mmmmmmmsa";
+      std::vector<FieldData> flds;
+      int  large  = rnd(100) < plarge;
+      long target = large ? maxsize / 2 + rnd(maxsize / 2) : 0;
+      std::string rec;
+
+      buildFields(flds, n + 1, fmin + rnd(fmax - fmin + 1), rnd(100) < pembedded, target);
+      while ((rec = buildRecord(flds, levels[rnd(9)])).empty())
+         flds.pop_back();   // too long: drop holdings //
+      fwrite(rec.data(), 1, rec.size(), fp);
+      bytes += rec.size();
+   }
+   if (fclose(fp) != 0)
+   {
+      perror(argv[cnt]);
+      return 1;
+   }
+   fprintf(stderr, "%ld records, %ld bytes\n", nrecs, bytes);
+   return 0;
+}
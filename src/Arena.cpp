@@ -0,0 +1,137 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstdlib>
+#include	<cstring>
+#include	<new>
+
+#include "Arena.h"
+
+
+#define ARENA_ALIGN	(sizeof(void*) < sizeof(long double) ? sizeof(long double) : sizeof(void*))
+#define ALIGNUP(n)	(((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+
+Arena::Arena( long bsz )
+{
+   blocksize = bsz;
+   first = cur = NULL;
+   ptr = end = NULL;
+   nmallocs = 0;
+   nallocs  = 0;
+}
+
+
+Arena::~Arena()
+{
+   Block *bp = first;
+   while (bp != NULL)
+   {
+      Block *nb = bp->next;
+      free(bp);
+      bp = nb;
+   }
+}
+
+
+Arena::Block * Arena::newBlock( long sz )
+{
+   Block *bp = (Block*) malloc(ALIGNUP(sizeof(Block)) + sz);
+   if (bp == NULL)
+      throw std::bad_alloc();
+   bp->next = NULL;
+   bp->size = sz;
+   ++nmallocs;
+   return bp;
+}
+
+
+//---------------------------------------------------------------------------------
+// alloc(long)
+//
+// restituisce sz byte allineati; se il blocco corrente e' pieno passa al
+// successivo (gia' allocato per un record precedente) o ne alloca uno nuovo
+//---------------------------------------------------------------------------------
+
+void * Arena::alloc( long sz )
+{
+   ++nallocs;
+   sz = (sz > 0) ? ALIGNUP(sz) : ARENA_ALIGN;
+   while (end - ptr < sz)
+   {
+      Block *nb = (cur != NULL) ? cur->next : first;
+      if (nb == NULL)
+      {
+         nb = newBlock((sz > blocksize) ? sz : blocksize);
+         if (cur != NULL)
+         {
+            nb->next  = cur->next;
+            cur->next = nb;
+         }
+         else
+         {
+            nb->next = first;
+            first    = nb;
+         }
+      }
+      cur = nb;
+      ptr = (char*) cur + ALIGNUP(sizeof(Block));
+      end = ptr + cur->size;
+   }
+   void *rp = ptr;
+   ptr += sz;
+   return rp;
+}
+
+
+char * Arena::copy( const char *src, long len )
+{
+   char *dp = (char*) alloc(len + 1);
+   if (len > 0)
+      memcpy(dp, src, len);
+   dp[len] = '\0';
+   return dp;
+}
+
+
+void Arena::reset()
+{
+   cur = NULL;
+   ptr = end = NULL;
+}
+
+
+long Arena::getMallocCount()
+{
+   return nmallocs;
+}
+
+
+long Arena::getAllocCount()
+{
+   return nallocs;
+}
@@ -0,0 +1,65 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+
+/*
+ * Arena: bump allocator for the fields and subfields of one record.
+ * Memory is handed out from large blocks and released all at once by
+ * reset(); the blocks are kept and reused for the next record, so in
+ * steady state reading a record does not call malloc at all.
+ */
+class Arena
+{
+  public:
+	Arena( long blocksize = 64 * 1024 );
+	~Arena();
+	void	*alloc( long sz );
+	char	*copy( const char *src, long len );
+	void	reset();
+	long	getMallocCount();
+	long	getAllocCount();
+
+  private:
+	struct Block
+	{
+		Block	*next;
+		long	size;
+	};
+	Block	*first;		// chain of all blocks //
+	Block	*cur;		// block in use //
+	char	*ptr;		// next free byte in cur //
+	char	*end;		// end of cur //
+	long	blocksize;
+	long	nmallocs;	// blocks allocated since construction //
+	long	nallocs;	// alloc() calls since construction //
+	Block	*newBlock( long sz );
+};
+
+#endif /* _ARENA_H_ */
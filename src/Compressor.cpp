@@ -0,0 +1,310 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cerrno>
+#include	<cstring>
+#include	<unistd.h>
+#include	<zlib.h>
+#ifdef HAVE_ZSTD
+#include	<zstd.h>
+#endif
+
+#include "Compressor.h"
+
+
+#define BLOCKSIZE	(1024 * 1024)	// uncompressed bytes per gzip member / zstd frame //
+#define ZSTD_LEVEL	3
+
+
+Compressor::Compressor()
+{
+   fd     = -1;
+   format = NONE;
+   err    = 0;
+   cur    = NULL;
+   nblocks = 0;
+   maxpending = 0;
+   stop   = 0;
+}
+
+
+Compressor::~Compressor()
+{
+   finish();
+}
+
+
+//---------------------------------------------------------------------------------
+// parseFormat(const char*)
+//
+// nome del formato dell'opzione -z; NONE se sconosciuto
+//---------------------------------------------------------------------------------
+
+int Compressor::parseFormat( const char *name )
+{
+   if ((strcmp(name, "gzip") == 0) || (strcmp(name, "gz") == 0))
+      return GZIP;
+   if ((strcmp(name, "zstd") == 0) || (strcmp(name, "zst") == 0))
+      return ZSTD;
+   return NONE;
+}
+
+
+int Compressor::isSupported( int format )
+{
+#ifdef HAVE_ZSTD
+   return (format == GZIP) || (format == ZSTD);
+#else
+   return (format == GZIP);
+#endif
+}
+
+
+//---------------------------------------------------------------------------------
+// open(int, int, int)
+//
+// avvia nthreads thread di compressione; i blocchi compressi vengono
+// scritti su fd, che resta del chiamante
+//---------------------------------------------------------------------------------
+
+int Compressor::open( int fd, int format, int nthreads )
+{
+   if (! isSupported(format))
+      return 0;
+   if (nthreads < 1)
+      nthreads = 1;
+   this->fd     = fd;
+   this->format = format;
+   err  = 0;
+   stop = 0;
+   nblocks = 0;
+   maxpending = 2 * nthreads;
+   for (int j = 0 ; j < nthreads ; ++j)
+      workers.push_back(std::thread(worker, this));
+   return 1;
+}
+
+
+//---------------------------------------------------------------------------------
+// write(const char*, long)
+//
+// accoda n byte al blocco corrente, passando ai thread i blocchi pieni;
+// restituisce 0 se la scrittura o la compressione sono fallite
+//---------------------------------------------------------------------------------
+
+int Compressor::write( const char *p, long n )
+{
+   while (n > 0)
+   {
+      if (cur == NULL)
+      {
+         cur = new Job();
+         cur->in.reserve(BLOCKSIZE);
+         cur->done = 0;
+      }
+      long k = BLOCKSIZE - cur->in.size();
+      if (k > n)
+         k = n;
+      cur->in.insert(cur->in.end(), p, p + k);
+      p += k;
+      n -= k;
+      if ((cur->in.size() == BLOCKSIZE) && ! submit())
+         return 0;
+   }
+   return (err == 0);
+}
+
+
+//---------------------------------------------------------------------------------
+// finish()
+//
+// comprime il blocco incompleto, scrive tutti i blocchi e ferma i thread;
+// senza dati scrive un member (o frame) vuoto, perche' un file di 0 byte
+// non e' un gzip / zstd valido. Restituisce 0 in caso di errore (anche
+// precedente)
+//---------------------------------------------------------------------------------
+
+int Compressor::finish()
+{
+   if (workers.empty())
+      return (err == 0);
+   if ((nblocks == 0) && (cur == NULL))
+   {
+      cur = new Job();
+      cur->done = 0;
+   }
+   submit();
+   while (! pending.empty())
+      writeOldest();
+   stopWorkers();
+   return (err == 0);
+}
+
+
+int Compressor::getError()
+{
+   return err;
+}
+
+
+// hand the current block to the workers, writing the oldest ones //
+// first if too many are in flight; an empty block only as the first //
+int Compressor::submit()
+{
+   if ((cur == NULL) || (cur->in.empty() && (nblocks > 0)))
+      return (err == 0);
+   while (pending.size() >= maxpending)
+      writeOldest();
+
+   std::lock_guard<std::mutex> lk(lock);
+   pending.push_back(cur);
+   work.push_back(cur);
+   cur = NULL;
+   ++nblocks;
+   workcv.notify_one();
+   return (err == 0);
+}
+
+
+// wait for the oldest block and write it (nothing more after an error) //
+int Compressor::writeOldest()
+{
+   Job *job;
+   {
+      std::unique_lock<std::mutex> lk(lock);
+      job = pending.front();
+      while (! job->done)
+         donecv.wait(lk);
+      pending.pop_front();
+   }
+
+   if ((err == 0) && job->out.empty())
+      err = EIO;   // compression failed //
+   const char *p = job->out.empty() ? NULL : &job->out[0];
+   long n = (err == 0) ? job->out.size() : 0;
+   while (n > 0)
+   {
+      ssize_t w = ::write(fd, p, n);
+      if (w < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         err = errno;
+         break;
+      }
+      p += w;
+      n -= w;
+   }
+   delete job;
+   return (err == 0);
+}
+
+
+void Compressor::stopWorkers()
+{
+   {
+      std::lock_guard<std::mutex> lk(lock);
+      stop = 1;
+   }
+   workcv.notify_all();
+   for (size_t j = 0 ; j < workers.size() ; ++j)
+      workers[j].join();
+   workers.clear();
+   delete cur;
+   cur = NULL;
+}
+
+
+//---------------------------------------------------------------------------------
+// thread di compressione
+//---------------------------------------------------------------------------------
+
+void Compressor::worker( Compressor *z )
+{
+   for (;;)
+   {
+      Job *job;
+      {
+         std::unique_lock<std::mutex> lk(z->lock);
+         while (z->work.empty() && ! z->stop)
+            z->workcv.wait(lk);
+         if (z->work.empty())
+            return;
+         job = z->work.front();
+         z->work.pop_front();
+      }
+
+      if (! z->compress(job))
+         job->out.clear();
+
+      std::lock_guard<std::mutex> lk(z->lock);
+      job->done = 1;
+      z->donecv.notify_all();
+   }
+}
+
+
+//---------------------------------------------------------------------------------
+// compress(Job*)
+//
+// comprime job->in in job->out come gzip member (o frame zstd) completo
+//---------------------------------------------------------------------------------
+
+int Compressor::compress( Job *job )
+{
+   char *in = job->in.empty() ? NULL : &job->in[0];
+
+   if (format == GZIP)
+   {
+      z_stream zs;
+      memset(&zs, 0, sizeof(zs));
+      // 15 + 16: gzip header and trailer //
+      if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+         return 0;
+      job->out.resize(deflateBound(&zs, job->in.size()));
+      zs.next_in   = (Bytef*) in;
+      zs.avail_in  = job->in.size();
+      zs.next_out  = (Bytef*) &job->out[0];
+      zs.avail_out = job->out.size();
+      int rc = deflate(&zs, Z_FINISH);
+      job->out.resize(zs.total_out);
+      deflateEnd(&zs);
+      return (rc == Z_STREAM_END);
+   }
+#ifdef HAVE_ZSTD
+   if (format == ZSTD)
+   {
+      job->out.resize(ZSTD_compressBound(job->in.size()));
+      size_t n = ZSTD_compress(&job->out[0], job->out.size(), in, job->in.size(), ZSTD_LEVEL);
+      if (ZSTD_isError(n))
+         return 0;
+      job->out.resize(n);
+      return 1;
+   }
+#endif
+   return 0;
+}
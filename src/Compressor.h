@@ -0,0 +1,92 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _COMPRESSOR_H_
+#define _COMPRESSOR_H_
+
+#include	<deque>
+#include	<vector>
+#include	<mutex>
+#include	<thread>
+#include	<condition_variable>
+
+
+/*
+ * Compressor: parallel block compression of the output (-z).
+ * The data written is cut into blocks of fixed size; each block is
+ * compressed on its own by one of N threads into a complete gzip member
+ * (or zstd frame, when built with HAVE_ZSTD) and the members are written
+ * to the file in order.  The result is a standard multi-member gzip /
+ * multi-frame zstd stream.  A file OutSink hands its buffer to the
+ * Compressor instead of writing it (OutSink::setCompressor).
+ */
+class Compressor
+{
+  public:
+	static const int NONE = 0;
+	static const int GZIP = 1;
+	static const int ZSTD = 2;
+
+	Compressor();
+	~Compressor();
+	static int  parseFormat( const char *name );
+	static int  isSupported( int format );
+	int	open( int fd, int format, int nthreads );
+	int	write( const char *p, long n );
+	int	finish();
+	int	getError();
+
+  private:
+	struct Job
+	{
+		std::vector<char> in;
+		std::vector<char> out;
+		int	done;
+	};
+
+	static void worker( Compressor *z );
+	int	compress( Job *job );
+	int	submit();
+	int	writeOldest();
+	void	stopWorkers();
+
+	int	fd;
+	int	format;
+	int	err;			// errno of the first failure //
+	Job	*cur;			// block being filled //
+	long	nblocks;		// blocks handed to the workers //
+	std::vector<std::thread> workers;
+	std::mutex	lock;
+	std::condition_variable	workcv;		// workers wait for blocks //
+	std::condition_variable	donecv;		// writer waits for the oldest block //
+	std::deque<Job*>	pending;	// blocks in output order //
+	std::deque<Job*>	work;		// blocks not yet taken by a worker //
+	size_t	maxpending;
+	int	stop;
+};
+
+#endif /* _COMPRESSOR_H_ */
@@ -0,0 +1,499 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cerrno>
+#include	<cstring>
+#include	<unistd.h>
+#include	<zlib.h>
+#ifdef HAVE_ZSTD
+#include	<zstd.h>
+#endif
+
+#include "Decompressor.h"
+
+
+#define INBLOCK		(1024 * 1024)	// compressed bytes read at a time //
+#define OUTBLOCK	(1024 * 1024)	// bytes per ring slot //
+
+
+Decompressor::Decompressor()
+{
+   fd      = -1;
+   format  = NONE;
+   head    = 0;
+   tail    = 0;
+   done    = 1;
+   stop    = 0;
+   readerwaits = 0;
+   writerwaits = 0;
+   curpos  = 0;
+   peekpos = 0;
+   error   = NULL;
+}
+
+
+Decompressor::~Decompressor()
+{
+   close();
+}
+
+
+//---------------------------------------------------------------------------------
+// detect(const unsigned char*, long)
+//
+// riconosce il formato compresso dai primi byte del file (magic number)
+//---------------------------------------------------------------------------------
+
+int Decompressor::detect( const unsigned char *magic, long len )
+{
+   if ((len >= 2) && (magic[0] == 0x1f) && (magic[1] == 0x8b))
+      return GZIP;
+   if ((len >= 4) && (magic[0] == 0x28) && (magic[1] == 0xb5) && (magic[2] == 0x2f) && (magic[3] == 0xfd))
+      return ZSTD;
+   return NONE;
+}
+
+
+int Decompressor::isSupported( int format )
+{
+#ifdef HAVE_ZSTD
+   return (format == NONE) || (format == GZIP) || (format == ZSTD);
+#else
+   return (format == NONE) || (format == GZIP);
+#endif
+}
+
+
+//---------------------------------------------------------------------------------
+// open(int, int)
+//
+// avvia il thread che legge (e decomprime) fd dalla posizione corrente;
+// con AUTO il formato viene riconosciuto dai primi byte letti, quindi
+// funziona anche su pipe. Il file descriptor resta del chiamante
+//---------------------------------------------------------------------------------
+
+int Decompressor::open( int fd, int format )
+{
+   close();
+   if ((format != AUTO) && ! isSupported(format))
+      return 0;
+   this->fd     = fd;
+   this->format = format;
+   head    = 0;
+   tail    = 0;
+   done    = 0;
+   stop    = 0;
+   curpos  = 0;
+   peekpos = 0;
+   peek.clear();
+   error   = NULL;
+   worker  = std::thread(&Decompressor::run, this);
+   return 1;
+}
+
+
+void Decompressor::close()
+{
+   if (worker.joinable())
+   {
+      stop = 1;
+      {
+         std::lock_guard<std::mutex> lk(lock);
+         cv.notify_all();
+      }
+      worker.join();
+   }
+   fd   = -1;
+   done = 1;
+}
+
+
+//---------------------------------------------------------------------------------
+// read(char*, long)
+//
+// copia in dst fino a len byte letti dal thread, attendendolo se il ring
+// e' vuoto; restituisce 0 a fine input o in caso di errore (vedi getError())
+//---------------------------------------------------------------------------------
+
+long Decompressor::read( char *dst, long len )
+{
+   long n = 0;
+
+   while (n < len)
+   {
+      unsigned long t = tail.load(std::memory_order_relaxed);
+      if (head.load() == t)
+      {
+         if (n > 0)
+            break;   // return what is there, do not wait //
+         if (done)
+         {
+            if (head.load() == t)
+               break;
+            continue;
+         }
+         wait(readerwaits, 0);
+         continue;
+      }
+
+      int  s = t % NSLOTS;
+      long k = slotlen[s] - curpos;
+      if (k > len - n)
+         k = len - n;
+      memcpy(dst + n, &slot[s][curpos], k);
+      curpos += k;
+      n += k;
+      if (curpos == slotlen[s])
+      {
+         // slot consumed: give it back to the thread //
+         curpos = 0;
+         tail.store(t + 1);
+         wake(writerwaits);
+      }
+   }
+   return n;
+}
+
+
+const char *Decompressor::getError()
+{
+   std::lock_guard<std::mutex> lk(lock);
+   return error;
+}
+
+
+void Decompressor::setError( const char *msg )
+{
+   std::lock_guard<std::mutex> lk(lock);
+   if (error == NULL)
+      error = msg;
+}
+
+
+//---------------------------------------------------------------------------------
+// wait(std::atomic<int>&, int) / wake(std::atomic<int>&)
+//
+// attesa sul ring vuoto (lettore) o pieno (thread). Chi attende dichiara
+// di dormire e poi ricontrolla gli indici; chi li aggiorna controlla poi
+// il flag: in ogni ordine almeno uno dei due vede la modifica dell'altro,
+// e il lock impedisce che la notifica arrivi prima della wait
+//---------------------------------------------------------------------------------
+
+void Decompressor::wait( std::atomic<int> &sleeping, int forspace )
+{
+   std::unique_lock<std::mutex> lk(lock);
+   sleeping = 1;
+   if (forspace)
+      while ((head.load() - tail.load() >= NSLOTS) && ! stop)
+         cv.wait(lk);
+   else
+      while ((head.load() == tail.load()) && ! done)
+         cv.wait(lk);
+   sleeping = 0;
+}
+
+
+void Decompressor::wake( std::atomic<int> &sleeping )
+{
+   if (sleeping)
+   {
+      std::lock_guard<std::mutex> lk(lock);
+      cv.notify_all();
+   }
+}
+
+
+//---------------------------------------------------------------------------------
+// thread di lettura
+//---------------------------------------------------------------------------------
+
+void Decompressor::run()
+{
+   if (format == AUTO)
+   {
+      // the format comes from the first bytes; readInput() serves them again //
+      char magic[4];
+      long n = readInput(magic, sizeof(magic));
+      if (n > 0)
+         peek.assign(magic, magic + n);
+      peekpos = 0;
+      format = detect((const unsigned char*) magic, n);
+   }
+
+   if (! isSupported(format))
+      setError("compressed input format not supported by this build");
+   else
+   if (format == GZIP)
+      inflateGzip();
+   else
+   if (format == ZSTD)
+      inflateZstd();
+   else
+      copyPlain();
+
+   done = 1;
+   wake(readerwaits);
+}
+
+
+// read(2) until len bytes or end of file; -1 on error //
+long Decompressor::readInput( char *dst, long len )
+{
+   long n = 0;
+   while ((n < len) && (peekpos < (long) peek.size()))
+      dst[n++] = peek[peekpos++];
+   while (n < len)
+   {
+      long k = ::read(fd, dst + n, len - n);
+      if ((k < 0) && (errno == EINTR))
+         continue;
+      if (k < 0)
+         return -1;
+      if (k == 0)
+         break;
+      n += k;
+   }
+   return n;
+}
+
+
+// buffer of the next free slot, waiting if the ring is full; NULL if stopped //
+char *Decompressor::getBlock()
+{
+   unsigned long h = head.load(std::memory_order_relaxed);
+   while ((h - tail.load() >= NSLOTS) && ! stop)
+      wait(writerwaits, 1);
+   if (stop)
+      return NULL;
+   std::vector<char> &b = slot[h % NSLOTS];
+   if (b.size() < OUTBLOCK)
+      b.resize(OUTBLOCK);
+   return &b[0];
+}
+
+
+// publish len bytes of the slot returned by getBlock(); 0 if stopped //
+int Decompressor::putBlock( long len )
+{
+   unsigned long h = head.load(std::memory_order_relaxed);
+   if (len > 0)
+   {
+      slotlen[h % NSLOTS] = len;
+      head.store(h + 1);
+      wake(readerwaits);
+   }
+   return ! stop;
+}
+
+
+//---------------------------------------------------------------------------------
+// copyPlain()
+//
+// input non compresso: i blocchi letti passano cosi' come sono
+//---------------------------------------------------------------------------------
+
+int Decompressor::copyPlain()
+{
+   char *bp;
+
+   while ((bp = getBlock()) != NULL)
+   {
+      long n = readInput(bp, OUTBLOCK);
+      if (n < 0)
+      {
+         setError("read error");
+         return 0;
+      }
+      if (n == 0)
+         break;
+      if (! putBlock(n))
+         break;
+   }
+   return 1;
+}
+
+
+//---------------------------------------------------------------------------------
+// inflateGzip()
+//
+// decomprime un file gzip, anche formato da piu' membri concatenati
+//---------------------------------------------------------------------------------
+
+int Decompressor::inflateGzip()
+{
+   std::vector<char> inbuf(INBLOCK);
+   z_stream zs;
+   const char *err = NULL;
+   int  ended = 0;     // last member complete //
+   int  outfull = 0;   // output filled up: more may be pending without new input //
+   int  rc;
+
+   memset(&zs, 0, sizeof(zs));
+   if (inflateInit2(&zs, 15 + 32) != Z_OK)   // 15 + 32: zlib or gzip header //
+   {
+      setError("gzip: cannot initialize zlib");
+      return 0;
+   }
+
+   char *blk = NULL;
+   while (err == NULL)
+   {
+      if ((zs.avail_in == 0) && ! outfull)
+      {
+         long k = readInput(&inbuf[0], INBLOCK);
+         if (k < 0)
+         {
+            err = "gzip: read error";
+            break;
+         }
+         if (k == 0)
+         {
+            if (! ended)
+               err = "gzip: unexpected end of file";
+            break;
+         }
+         zs.next_in  = (Bytef*) &inbuf[0];
+         zs.avail_in = k;
+      }
+      if (ended && (zs.avail_in > 0))
+      {
+         // another gzip member follows //
+         inflateReset(&zs);
+         ended = 0;
+      }
+
+      if (blk == NULL)
+      {
+         if ((blk = getBlock()) == NULL)
+            break;
+         zs.next_out  = (Bytef*) blk;
+         zs.avail_out = OUTBLOCK;
+      }
+      rc = inflate(&zs, Z_NO_FLUSH);
+      if (rc == Z_STREAM_END)
+         ended = 1;
+      else
+      if ((rc != Z_OK) && (rc != Z_BUF_ERROR))
+         err = "gzip: corrupt input data";
+
+      outfull = (zs.avail_out == 0);
+      if (outfull)
+      {
+         int more = putBlock(OUTBLOCK);
+         blk = NULL;
+         if (! more)
+            break;
+      }
+   }
+   if (blk != NULL)
+      putBlock(OUTBLOCK - zs.avail_out);
+   inflateEnd(&zs);
+
+   if (err != NULL)
+      setError(err);
+   return (err == NULL);
+}
+
+
+//---------------------------------------------------------------------------------
+// inflateZstd()
+//
+// decomprime un file zstd (disponibile solo se compilato con HAVE_ZSTD)
+//---------------------------------------------------------------------------------
+
+int Decompressor::inflateZstd()
+{
+#ifdef HAVE_ZSTD
+   std::vector<char> inbuf(INBLOCK);
+   ZSTD_inBuffer  zin  = { &inbuf[0], 0, 0 };
+   ZSTD_outBuffer zout = { NULL, 0, 0 };
+   const char *err = NULL;
+   size_t rc = 0;    // 0: frame complete //
+   int  outfull = 0;
+
+   ZSTD_DStream *zs = ZSTD_createDStream();
+   if (zs == NULL)
+   {
+      setError("zstd: cannot initialize decoder");
+      return 0;
+   }
+   ZSTD_initDStream(zs);
+
+   char *blk = NULL;
+   while (err == NULL)
+   {
+      if ((zin.pos == zin.size) && ! outfull)
+      {
+         long k = readInput(&inbuf[0], INBLOCK);
+         if (k < 0)
+         {
+            err = "zstd: read error";
+            break;
+         }
+         if (k == 0)
+         {
+            if (rc != 0)
+               err = "zstd: unexpected end of file";
+            break;
+         }
+         zin.size = k;
+         zin.pos  = 0;
+      }
+
+      if (blk == NULL)
+      {
+         if ((blk = getBlock()) == NULL)
+            break;
+         zout.dst  = blk;
+         zout.size = OUTBLOCK;
+         zout.pos  = 0;
+      }
+      rc = ZSTD_decompressStream(zs, &zout, &zin);
+      if (ZSTD_isError(rc))
+         err = "zstd: corrupt input data";
+
+      outfull = (zout.pos == zout.size);
+      if (outfull)
+      {
+         int more = putBlock(OUTBLOCK);
+         blk = NULL;
+         if (! more)
+            break;
+      }
+   }
+   if (blk != NULL)
+      putBlock(zout.pos);
+   ZSTD_freeDStream(zs);
+
+   if (err != NULL)
+      setError(err);
+   return (err == NULL);
+#else
+   setError("zstd: not supported (build with HAVE_ZSTD)");
+   return 0;
+#endif
+}
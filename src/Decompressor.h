@@ -0,0 +1,98 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _DECOMPRESSOR_H_
+#define _DECOMPRESSOR_H_
+
+#include	<atomic>
+#include	<vector>
+#include	<mutex>
+#include	<thread>
+#include	<condition_variable>
+
+
+/*
+ * Decompressor: read-ahead thread for input that cannot be mapped.
+ * The thread reads the input in large blocks and, for gzip (zlib) and,
+ * when built with HAVE_ZSTD, zstd input, decompresses it; plain input
+ * (a pipe, standard input) is passed through as it is, so reading
+ * overlaps with framing and parsing in both cases.  The blocks are
+ * handed to read() through a single-producer / single-consumer ring:
+ * the slots are exchanged with two atomic counters, and the mutex is
+ * only used to sleep when the ring is empty or full.
+ */
+class Decompressor
+{
+  public:
+	static const int NONE = 0;
+	static const int GZIP = 1;
+	static const int ZSTD = 2;
+	static const int AUTO = -1;	// detect from the first bytes read //
+
+	Decompressor();
+	~Decompressor();
+	static int  detect( const unsigned char *magic, long len );
+	static int  isSupported( int format );
+	int	open( int fd, int format );
+	long	read( char *dst, long len );
+	void	close();
+	const char *getError();
+
+  private:
+	static const int NSLOTS = 8;
+
+	void	run();
+	int	copyPlain();
+	int	inflateGzip();
+	int	inflateZstd();
+	long	readInput( char *dst, long len );
+	char	*getBlock();
+	int	putBlock( long len );
+	void	wait( std::atomic<int> &sleeping, int forspace );
+	void	wake( std::atomic<int> &sleeping );
+	void	setError( const char *msg );
+
+	int	fd;
+	int	format;
+	std::thread	worker;
+	std::vector<char> slot[NSLOTS];	// block buffers of the ring //
+	long	slotlen[NSLOTS];	// bytes in each filled slot //
+	std::atomic<unsigned long> head;	// slots filled by the thread //
+	std::atomic<unsigned long> tail;	// slots consumed by read() //
+	std::atomic<int> done;		// thread finished (end of input or error) //
+	std::atomic<int> stop;		// close() asked the thread to quit //
+	std::atomic<int> readerwaits;	// read() sleeps on an empty ring //
+	std::atomic<int> writerwaits;	// the thread sleeps on a full ring //
+	std::mutex	lock;
+	std::condition_variable	cv;
+	long	curpos;			// read position in slot tail % NSLOTS //
+	std::vector<char> peek;		// first bytes read to detect the format //
+	long	peekpos;
+	const char *error;
+};
+
+#endif /* _DECOMPRESSOR_H_ */
@@ -0,0 +1,119 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstdio>
+#include	<cstring>
+
+#include "Directory.h"
+
+
+// Appends msg as one line of msgs, if given.
+static void report( std::string *msgs, const char *msg )
+{
+   if (msgs == NULL)
+      return;
+   *msgs += msg;
+   *msgs += '\n';
+}
+
+
+//---------------------------------------------------------------------------------
+// decode(const char*, long, char*, int&, std::string*)
+//
+// legge etichetta e geometria della directory del record lungo recsz byte
+// che inizia in rec; copia l'etichetta in label (LABELSIZE+1 byte), somma a
+// status i bit di errore e ne aggiunge le righe a msgs. Restituisce 0 se la
+// directory non si puo' leggere, e allora il record non ha campi
+//---------------------------------------------------------------------------------
+
+int Directory::decode( const char *rp, long recsz, char *label, int &status, std::string *msgs )
+{
+   rec   = rp;
+   end   = rp + recsz;
+   dir   = rp + LABELSIZE;
+   dbase = sbase = dir;
+   nentries = 0;
+   flen = foff = esize = 0;
+
+   if (recsz < LABELSIZE)
+   {
+      // record shorter than its label: kept for the discarded records //
+      memcpy(label, rp, recsz);
+      label[recsz] = '\0';
+      status |= RecordIso2709::BAD_LABEL;
+      report(msgs, "ERROR: record shorter than the label");
+      return 0;
+   }
+   memcpy(label, rp, LABELSIZE);
+   label[LABELSIZE] = '\0';
+
+   if (strutils::hasIllegalCharacters(label))
+   {
+      status |= RecordIso2709::BAD_LABEL;
+      report(msgs, "ERROR: illegal characters in label");
+   }
+
+   long len = strutils::strntolong(label, 5);   // record length [0-4] //
+   if (len < LABELSIZE)
+   {
+      status |= RecordIso2709::BAD_LABEL;
+      report(msgs, "ERROR: invalid record length in label");
+      return 0;
+   }
+
+#ifdef FORMAT_PATCH
+   if (len != recsz)
+   {
+      char errmsg[80];
+      sprintf(errmsg, "invalid record length: %ld : %ld", len, recsz);
+      report(msgs, errmsg);
+   }
+#endif
+
+   long dataoffs = strutils::strntolong(label + 12, 5);   // data offset [12-17] //
+   flen  = CTOI(label[20]);     // dir. entry length indication [20] //
+   foff  = CTOI(label[21]);     // dir. entry offset indication [21] //
+   esize = 3 + flen + foff;
+   nentries = (dataoffs - LABELSIZE - 1) / esize;
+
+   if ((nentries < 0) || (dir + nentries * esize >= end))
+   {
+      status |= RecordIso2709::BAD_DATA;
+      return 0;
+   }
+
+   if ((flen == 0) || (foff == 0))
+   {
+      report(msgs, "ERROR: directory entry map without length or offset width");
+      status |= RecordIso2709::BAD_DIRECTORY;
+      return 0;
+   }
+
+   dbase = rp + dataoffs;
+   sbase = dir + nentries * esize + 1;   // after the directory FT //
+   return 1;
+}
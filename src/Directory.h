@@ -0,0 +1,120 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _DIRECTORY_H_
+#define _DIRECTORY_H_
+
+#include	<string>
+
+#include	"RecordIso2709.h"
+#include	"strutils.h"
+
+
+/*
+ * Directory: label and directory of an ISO 2709 record, decoded in place.
+ * It is the one directory decoder of the parser: RecordIso2709::decode()
+ * keeps the entries it returns in a FieldList, RecordVisitor::visit()
+ * walks them straight off the record buffer.  decode() checks the label
+ * and the directory bounds; entry() gives length and offset of entry j
+ * and locate() finds the data of a field, at its offset or, if the offset
+ * is wrong, right after the previous field as in a sequential directory.
+ * Nothing is allocated: the object only points into the record.
+ */
+class Directory
+{
+  public:
+	int	decode( const char *rec, long recsz, char *label, int &status,
+			std::string *msgs = NULL );
+	inline long	getCount()		{ return nentries; }
+	inline int	getLengthWidth()	{ return flen; }
+	inline int	getOffsetWidth()	{ return foff; }
+	inline int	getEntrySize()		{ return esize; }
+	// first entry of the directory //
+	inline const char *getEntries()		{ return dir; }
+	// first byte after the directory and its FT //
+	inline const char *getFields()		{ return sbase; }
+
+	// length (FT excluded) and offset of the entry at bp; 1 if they are //
+	// not all digits, then read as strutils::strntolong() does           //
+	template <int FL, int FO>
+	inline int entry( const char *bp, long &len, long &offs )
+	{
+		const int fl = FL ? FL : flen;
+		const int fo = FO ? FO : foff;
+		unsigned bad = 0;
+		len  = digits(bp + 3, fl, bad) - 1;
+		offs = digits(bp + 3 + fl, fo, bad);
+		if (bad)
+		{
+			len  = strutils::strntolong((char*) bp + 3, fl) - 1;
+			offs = strutils::strntolong((char*) bp + 3 + fl, fo);
+		}
+		return bad != 0;
+	}
+
+	// data of a field of length len at offset offs, or at seqoffs from //
+	// getFields(); NULL if a FT does not follow it in either place     //
+	inline const char *locate( long len, long offs, long seqoffs )
+	{
+		const char *fdp = dbase + offs;
+		if (isFieldAt(fdp, len))
+			return fdp;
+		fdp = sbase + seqoffs;
+		if (isFieldAt(fdp, len))
+			return fdp;
+		return NULL;
+	}
+
+  private:
+	static inline long digits( const char *p, int n, unsigned &bad )
+	{
+		long v = 0;
+		for (int j = 0 ; j < n ; ++j)
+		{
+			unsigned d = (unsigned char) p[j] - '0';
+			bad |= (d > 9);
+			v = v * 10 + d;
+		}
+		return v;
+	}
+	inline int isFieldAt( const char *fdp, long len )
+	{
+		return (len >= 0) && (fdp >= rec + LABELSIZE) && (fdp + len < end) && (fdp[len] == FT);
+	}
+
+	const char	*rec;
+	const char	*end;		// end of the record data //
+	const char	*dir;		// first directory entry //
+	const char	*dbase;		// base address of the field offsets //
+	const char	*sbase;		// base of a sequential directory //
+	long	nentries;
+	int	flen;			// width of the field length, label[20] //
+	int	foff;			// width of the field offset, label[21] //
+	int	esize;
+};
+
+#endif /* _DIRECTORY_H_ */
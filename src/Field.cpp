@@ -28,15 +28,22 @@
 #include	<iostream>
 #include	<cstdlib>
 #include        <cstring>
+#include        <new>
 
 #include "Field.h"
+#include "Arena.h"
 #include "strutils.h"
+#include "scanutils.h"
 
 
-Field::Field()
+Field::Field( Arena *ar )
 {
-   next  = NULL;
+   arena = ar;
    fdata = NULL;
+   fowned = 0;
+   fpartial = 0;
+   subfields = NULL;
+   sfcount   = 0;
    ind1  = '\0';
    ind2  = '\0';
    ftag[0]= '\0';
@@ -47,25 +54,48 @@ Field::Field()
 
 Field::~Field()
 {
-   if (fdata != NULL)
+   if (arena != NULL)   // memory is released by Arena::reset() //
+      return;
+
+   if ((fdata != NULL) && fowned)
    {
 	delete[] fdata;
 	fdata = NULL;
    }
-                
-   while (! subfields.empty() )
+   if (subfields != NULL)
    {
-      SubField *sf = subfields.back();
-      subfields.pop_back();
-      if (sf != NULL)
-      {
-	      delete sf;
-	      sf = NULL;
-      }
+	delete[] subfields;
+	subfields = NULL;
    }
 }
 
 
+Arena * Field::getArena()
+{
+   return arena;
+}
+
+
+char * Field::allocData(int len)
+{
+   if (arena != NULL)
+      return (char*) arena->alloc(len);
+   return new char[len];
+}
+
+
+SubField * Field::allocSubFields(int n)
+{
+   if (arena == NULL)
+      return new SubField[n];
+
+   SubField *sfv = (SubField*) arena->alloc(n * sizeof(SubField));
+   for (int j = 0 ; j < n ; ++j)
+      new (sfv + j) SubField();
+   return sfv;
+}
+
+
 void Field::setTag(char *tp, int len )
 {
    memcpy(ftag, tp, 3);
@@ -80,10 +110,19 @@ char* Field::getTag()
 }
 
 
+//---------------------------------------------------------------------------------
+// getData()
+//
+// dati del campo (getLength() byte, non terminati da '\0'); per un campo dati
+// non modificato e' la vista sul record, altrimenti il campo viene ricostruito
+// dagli indicatori e dai subfield
+//---------------------------------------------------------------------------------
+
 char * Field::getData()
 {
   int sz, offs;
   int len = 0;
+  char *dp;
 
   switch(fieldType)
   {
@@ -91,28 +130,34 @@ char * Field::getData()
             return fdata;
 	    break;
     case 1:	// data field
+	    if ((fdata != NULL) && ! isModified())
+	       return fdata;
 	    len = 2;
-            sz = subfields.size();
+            sz = sfcount;
             for (int j = 0 ; j < sz ; ++j)
             {
-               SubField *sf = subfields[j];
+               SubField *sf = &subfields[j];
                len += sf->getLength() + 1;
             }
-            fdata = new char[len+1];
+            dp = allocData(len+1);
         // std::cerr << "tag: " << ftag << " len=" << len << '\n';
 	    offs = 0;
-	    fdata[offs++] = ind1;
-	    fdata[offs++] = ind2;
+	    dp[offs++] = ind1;
+	    dp[offs++] = ind2;
             for (int j = 0 ; j < sz ; ++j)
             {
-	       fdata[offs++] = SF;
-               SubField *sf = subfields[j];
-	       //fdata[offs++] = sf->getId();
+	       dp[offs++] = SF;
+               SubField *sf = &subfields[j];
+	       //dp[offs++] = sf->getId();
                len = sf->getLength();
-	       memcpy(fdata+offs,sf->getRawData(),len);
+	       memcpy(dp+offs,sf->getRawData(),len);
 	       offs += len;
             }
-	    fdata[offs] = '\0';
+	    dp[offs] = '\0';
+	    if (fowned && (arena == NULL))
+	       delete[] fdata;
+	    fdata  = dp;
+	    fowned = 1;
 	    flength = offs;
 	    isValidLength = 1;
             return fdata;
@@ -121,33 +166,154 @@ char * Field::getData()
 	    return NULL;
 	    break;
   }
+  return NULL;
 }
 
 
 
-void Field::parseSubFields(char *str, int sl, char delim )
+// subfield code selected by the bitmap (NULL: all codes) //
+#define SELECTED(codes,c)  (((codes) == NULL) || \
+			   ((codes)[(unsigned char)(c) >> 3] & (1 << ((unsigned char)(c) & 7))))
+
+
+void Field::parseSubFields(char *str, int sl, char delim, const unsigned char *codes )
 {
    char *p1, *p2, *eofs;
    if (str == NULL)
       return;
 
    eofs = str + sl; // pointer to end of string //
-   p1   = p2 = (str[0] == delim) ? str + 1 : str;
+   p1   = (str[0] == delim) ? str + 1 : str;
 
+   // count subfields, then split //
+   int n = 0;
+   for (p2 = p1 ; p2 < eofs ; ++p2, ++n)
+   {
+      p2 = scanutils::findByte(p2, eofs - p2, delim);
+      if (p2 == NULL)
+         p2 = eofs;
+   }
+   if (n == 0)
+      return;
+   subfields = allocSubFields(n);
+
+   p2 = p1;
    while (p2 < eofs)
    {
       // find next position of delimiter //
-      while ( (*p2 != delim) && (p2 < eofs) )
-            ++p2;
+      p2 = scanutils::findByte(p1, eofs - p1, delim);
+      if (p2 == NULL)
+         p2 = eofs;
 
       int l = p2 - p1;
-      SubField *subfld = new SubField(p1,l);
-      subfields.push_back(subfld);
+      if (SELECTED(codes, *p1))
+         subfields[sfcount++].init(arena, p1, l);
+      else
+         fpartial = 1;
       p1 = ++p2;
    }
 }
 
 
+//---------------------------------------------------------------------------------
+// parseSubFields(char*, int, char**, int, const unsigned char*)
+//
+// come sopra, ma con le posizioni dei delimitatori gia' note (dpos, ordinate,
+// tutte dentro str[0..sl)) dalla scansione del record: dpos puo' contenere
+// anche FT e RT, che vengono ignorati.  Con codes vengono tenuti solo i
+// subfield con i codici selezionati
+//---------------------------------------------------------------------------------
+
+void Field::parseSubFields(char *str, int sl, char **dpos, int nd, const unsigned char *codes )
+{
+   char *p1, *eofs;
+   if ((str == NULL) || (sl <= 0))
+      return;
+
+   eofs = str + sl; // pointer to end of string //
+   p1   = (str[0] == SF) ? str + 1 : str;
+
+   // count subfields, then split //
+   int n = 0;
+   char *last = p1 - 1;
+   for (int j = 0 ; j < nd ; ++j)
+      if ((dpos[j] >= p1) && (*dpos[j] == SF))
+      {
+         last = dpos[j];
+         ++n;
+      }
+   if (last + 1 < eofs)
+      ++n;   // data after the last delimiter //
+   if (n == 0)
+      return;
+   subfields = allocSubFields(n);
+
+   for (int j = 0 ; j < nd ; ++j)
+   {
+      char *p2 = dpos[j];
+      if ((p2 < p1) || (*p2 != SF))
+         continue;
+      if (SELECTED(codes, *p1))
+         subfields[sfcount++].init(arena, p1, p2 - p1);
+      else
+         fpartial = 1;
+      p1 = p2 + 1;
+   }
+   if (p1 < eofs)
+   {
+      if (SELECTED(codes, *p1))
+         subfields[sfcount++].init(arena, p1, eofs - p1);
+      else
+         fpartial = 1;
+   }
+}
+
+
+//---------------------------------------------------------------------------------
+// setRawData(char*, int, char**, int, const unsigned char*)
+//
+// dpos/nd: posizioni dei delimitatori nel campo, nd < 0 se non sono note;
+// codes: bitmap dei codici dei subfield da tenere, NULL per tutti
+//---------------------------------------------------------------------------------
+
+void Field::setRawData(char *dp, int len, char **dpos, int nd, const unsigned char *codes)
+{
+  if ((fieldType != 1) || (len < 2))
+  {
+    setRawData(dp, len);
+    return;
+  }
+  if (nd < 0)
+  {
+    flength = len;
+    isValidLength = 1;
+    fdata = dp;
+    ind1 = dp[0];
+    ind2 = dp[1];
+    parseSubFields(dp + 2, len - 2, SF, codes);
+    if (fpartial)
+       isValidLength = 0;   // length of the kept subfields only //
+    return;
+  }
+
+  flength = len;
+  isValidLength = 1;
+  fdata = dp;   // view on the record //
+  ind1 = dp[0];
+  ind2 = dp[1];
+
+  // skip delimiters falling on the indicators //
+  while ((nd > 0) && (*dpos < dp + 2))
+  {
+    ++dpos;
+    --nd;
+  }
+  parseSubFields(dp + 2, len - 2, dpos, nd, codes);
+  if (fpartial)
+     isValidLength = 0;   // length of the kept subfields only //
+}
+
+
 void Field::setRawData(char *dp, int len)
 {
   int l = (len) ? len : strlen(dp);
@@ -159,18 +325,16 @@ void Field::setRawData(char *dp, int len)
   switch(fieldType)
   {
     case 2:	// control field
-            fdata = new char[l+1];
-            memcpy(fdata, dp, l);
-            fdata[l]='\0';
+            fdata = dp;   // view on the record //
 	    break;
     case 1:	// data field
+            fdata = dp;
 	    ind1 = *dp++;
 	    ind2 = *dp++;
 	    l -= 2;
-            parseSubFields(dp,l,SF);
+            parseSubFields(dp,l,SF,NULL);
 	    break;
-    case 0:	// undefined
-            std::cerr << "Error: Tag not specified.\n";
+    case 0:	// undefined: no tag set, data ignored //
 	    return;
 	    break;
   }
@@ -189,14 +353,14 @@ long Field::getLength()
   {
     case 2:	// control field
 	    if (fdata != NULL)
-	       len = strlen(fdata);
+	       len = flength;
 	    break;
     case 1:	// data field
 	    len = 2;
-            sz = subfields.size();
+            sz = sfcount;
             for (int j = 0 ; j < sz ; ++j)
             {
-               SubField *sf = subfields[j];
+               SubField *sf = &subfields[j];
                len += sf->getLength() + 1;
             }
 	    break;
@@ -204,7 +368,26 @@ long Field::getLength()
 	    return 0;
 	    break;
   }
-  return(len + 1);
+  return(len);
+}
+
+
+//---------------------------------------------------------------------------------
+// isModified()
+//
+// 1 se il contenuto del campo non coincide piu' con quello letto dal record
+//---------------------------------------------------------------------------------
+
+int Field::isModified()
+{
+  if (fieldType == 2)
+     return fowned;
+  if (fpartial)
+     return 1;   // some subfields were not extracted //
+  for (int j = 0 ; j < sfcount ; ++j)
+     if (subfields[j].isModified())
+        return 1;
+  return 0;
 }
 
 
@@ -224,18 +407,34 @@ void Field::setOffset(long offs)
 	foffset = offs;
 }
 
-Field * Field::getNext()
+int Field::isControlField()
 {
-	return next;
+ 	return (fieldType == 2);
 }
 
-void Field::setNext(Field *fp)
+int Field::getSubFieldCount()
 {
-	next = fp;
+	return sfcount;
 }
-int Field::isControlField()
+
+SubField * Field::getSubField(int j)
 {
- 	return (fieldType == 2);
+	return ((j >= 0) && (j < sfcount)) ? subfields + j : NULL;
+}
+
+
+//---------------------------------------------------------------------------------
+// findSubField(char, int)
+//
+// n-esimo subfield (da 0) con codice 'code', NULL se non presente
+//---------------------------------------------------------------------------------
+
+SubField * Field::findSubField(char code, int n)
+{
+	for (int j = 0 ; j < sfcount ; ++j)
+	   if ((subfields[j].getId() == code) && (n-- == 0))
+	      return subfields + j;
+	return NULL;
 }
 
 char Field::getInd1()
@@ -248,22 +447,30 @@ char Field::getInd2()
 	return ind2;
 }
 
-void Field::print(std::ostream &os)
+void Field::print(OutSink &os)
 {
   int sz;
    switch (fieldType)
    {
     case 2:
-	    os << ftag << ": " << fdata << '\n';
+	    os.puts(ftag);
+	    os.write(": ", 2);
+	    if (fdata != NULL)
+	       os.write(fdata, flength);
+	    os.put('\n');
 	    break;
     case 1:
-	    os << ftag << ":[" << ind1 << ind2 << "] ";
-            sz = subfields.size();
+	    os.puts(ftag);
+	    os.write(":[", 2);
+	    os.put(ind1);
+	    os.put(ind2);
+	    os.write("] ", 2);
+            sz = sfcount;
             for (int j = 0 ; j < sz ; ++j)
             {
-               SubField *sf = subfields[j];
+               SubField *sf = &subfields[j];
 	       if (j > 0)
-		  os << "\t " ;
+		  os.write("\t ", 2);
                sf->print(os);
             }
             break;
@@ -273,14 +480,12 @@ void Field::print(std::ostream &os)
 }
 
 
-void	Field::printXML(std::ostream& os, int indent)
+void	Field::printXML(OutSink& os, int indent)
 {
   int sz;
   int inS1 = 0;
   int inDF = 0;
-  char space[] = "                                        "; // 40 spaces //
   int  spc;
-  char *cp;
 
   if (indent < 0)
     spc = 0;
@@ -290,82 +495,75 @@ void	Field::printXML(std::ostream& os, int indent)
    switch (fieldType)
    {
     case 2:
-	    os.write(space,spc);
-	    os << "<cf t=\"" << ftag << "\">";
-	    cp = fdata;
-	    while (*cp)
-	    {
-		    switch(*cp)
-		    {
-			    case '<': os << "&lt;"; break;
-			    case '>': os << "&gt;"; break;
-			    case '&': os << "&amp;"; break;
-			    default :  os.put(*cp);
-		    }
-		    ++cp;
-	    }
-	    os << "</cf>";
-	    if (spc > 0) os << '\n';
+	    os.spaces(spc);
+	    os.write("<cf t=\"", 7);
+	    os.writeXML(ftag, strlen(ftag), 1);
+	    os.write("\">", 2);
+	    if (fdata != NULL)
+	       os.writeXML(fdata, flength);
+	    os.write("</cf>", 5);
+	    if (spc > 0) os.put('\n');
 	    break;
     case 1:
-	    os.write(space,spc);
-	    os << "<df t=\"" << ftag << "\" i1=\""
-		    << ind1 << "\" i2=\"" << ind2 << "\">";
-	    if (spc > 0) os << '\n';
-            sz = subfields.size();
+	    os.spaces(spc);
+	    os.write("<df t=\"", 7);
+	    os.writeXML(ftag, strlen(ftag), 1);
+	    os.write("\" i1=\"", 6);
+	    os.putAttr(ind1);
+	    os.write("\" i2=\"", 6);
+	    os.putAttr(ind2);
+	    os.write("\">", 2);
+	    if (spc > 0) os.put('\n');
+            sz = sfcount;
             for (int j = 0 ; j < sz ; ++j)
             {
 	        // patch per unimarc: gestione link fields (4xx) //
 		char * data;
-		SubField *sf = subfields[j];
+		int    dl;
+		SubField *sf = &subfields[j];
 		if (sf->getId() == '1')
 		{
 		  if (inS1)
 		  {
 		    if (inDF)
 		    {
-	              os.write(space,2*spc);
-		      os << "</df>";
-	              if (spc > 0) os << '\n';
+	              os.spaces(2*spc);
+		      os.write("</df>", 5);
+	              if (spc > 0) os.put('\n');
 		      inDF = 0;
 		    }
-	            os.write(space,spc);
-		    os << "</s1>";
-	            if (spc > 0) os << '\n';
+	            os.spaces(spc);
+		    os.write("</s1>", 5);
+	            if (spc > 0) os.put('\n');
 		  }
-	          os.write(space,spc);
-		  os << "<s1>";
-	          if (spc > 0) os << '\n';
+	          os.spaces(spc);
+		  os.write("<s1>", 4);
+	          if (spc > 0) os.put('\n');
 		  inS1 = 1;
 		  data = sf->getData();
-		  if ((data[0] == '0') && (data[1] == '0')) // control field
+		  dl   = sf->getLength() - 1;
+		  if ((dl >= 2) && (data[0] == '0') && (data[1] == '0')) // control field
 		  {
-	            os.write(space,2*spc);
-		    os << "<cf t=\"";
-		    os.write(data,3);
-		    os << "\">";
-	            cp = data+3;
-	            while (*cp)
-	            {
-		       switch(*cp)
-		       {
-			    case '<': os << "&lt;"; break;
-			    case '>': os << "&gt;"; break;
-			    case '&': os << "&amp;"; break;
-			    default :  os.put(*cp);
-		       }
-		       ++cp;
-	            }
-		    os << "</cf>";
-	            if (spc > 0) os << '\n';
+	            os.spaces(2*spc);
+		    os.write("<cf t=\"", 7);
+		    os.writeXML(data, (dl < 3) ? dl : 3, 1);
+		    os.write("\">", 2);
+		    if (dl > 3)
+		       os.writeXML(data+3, dl-3);
+		    os.write("</cf>", 5);
+	            if (spc > 0) os.put('\n');
 		  }
 		  else // data field
 		  {
-	            os.write(space,2*spc);
-		    os << "<df t=\"";
-		    os.write(data,3);
-		    os << "\" i1=\"" << data[3] << "\" i2=\"" << data[4] << "\">";
-	            if (spc > 0) os << '\n';
+	            os.spaces(2*spc);
+		    os.write("<df t=\"", 7);
+		    os.writeXML(data, (dl < 3) ? ((dl < 0) ? 0 : dl) : 3, 1);
+		    os.write("\" i1=\"", 6);
+		    os.putAttr((dl > 3) ? data[3] : ' ');
+		    os.write("\" i2=\"", 6);
+		    os.putAttr((dl > 4) ? data[4] : ' ');
+		    os.write("\">", 2);
+	            if (spc > 0) os.put('\n');
 		    inDF = 1;
 		  }
 		}
@@ -374,19 +572,19 @@ void	Field::printXML(std::ostream& os, int indent)
             }
 	    if (inDF)
 	    {
-	       os.write(space,2*spc);
- 	       os << "</df>";
-	       if (spc > 0) os << '\n';
+	       os.spaces(2*spc);
+ 	       os.write("</df>", 5);
+	       if (spc > 0) os.put('\n');
 	    }
 	    if (inS1)
 	    {
-	       os.write(space,spc);
-	       os << "</s1>";
-	       if (spc > 0) os << '\n';
+	       os.spaces(spc);
+	       os.write("</s1>", 5);
+	       if (spc > 0) os.put('\n');
 	    }
-	    os.write(space,spc);
-	    os <<  "</df>";
-	    if (spc > 0) os << '\n';
+	    os.spaces(spc);
+	    os.write("</df>", 5);
+	    if (spc > 0) os.put('\n');
             break;
     case 0:
 	    break;
@@ -403,18 +601,28 @@ void Field::deleteControlCharacters()
    {
     case 2:
 	    // TODO: check control field contents //
-	    if (fdata != NULL)
+	    if ((fdata != NULL) && strutils::hasControlCharacters(fdata, flength))
 	    {
-		newdata = strutils::deleteControlCharacters(fdata);
+		if (! fowned)
+		{
+		   newdata = allocData(flength+1);
+		   memcpy(newdata, fdata, flength);
+		   fdata  = newdata;
+		   fowned = 1;
+		}
+		flength = strutils::deleteControlCharacters(fdata, flength);
+		fdata[flength] = '\0';
 	    }
 	    break;
     case 1:
-            sz = subfields.size();
+            sz = sfcount;
             for (int j = 0 ; j < sz ; ++j)
             {
-               SubField *sf = subfields[j];
+               SubField *sf = &subfields[j];
                sf->deleteControlCharacters();
             }
+	    if (isModified())
+	       isValidLength = 0;   // length must be recalculated //
             break;
     case 0:
 	    break;
@@ -29,10 +29,12 @@
 #define _FIELD_H_
 
 #include <iostream>
-#include <vector>
+
+#include "OutSink.h"
 
 #define SF 31  /* ^_ subfield delimiter; printed $ in MARC specs */
 
+class Arena;
 
 class SubField
 {
@@ -41,6 +43,7 @@ class SubField
 	SubField(char*,int);
 	SubField(char,char*,int);
 	~SubField();
+	void init(Arena *ar, char *dp, int len);
 	char getId();
 	void setId(char);
 	char* getRawData();
@@ -49,48 +52,65 @@ class SubField
 	void  setRawData(char*);
 	void  setRawData(char*,int);
 	int   getLength();
-	void	print(std::ostream& os);
-	void	printXML(std::ostream& os, int indent);
+	int   isModified();
+	void	print(OutSink& os);
+	void	printXML(OutSink& os, int indent);
 	void	deleteControlCharacters();
   private:
 	char	id;
-	char	*data;
+	char	*data;	// id + value; view on the record until modified //
+	int	len;	// length of data, id included //
+	int	owned;	// data is a private copy (materialized) //
+	Arena	*arena;	// where copies are allocated; NULL: new[] //
+	char   *allocData(int len);
+	void	materialize(int sz);
 };
 
 
 class Field
 {
   public:
-	Field();
+	Field( Arena *ar = NULL );
 	~Field();
+	Arena *getArena();
 	long   getLength();
 	void   setLength(long len);
 	long   getOffset();
 	void   setOffset(long offs);
 	char  *getData();
 	void   setRawData(char *dp, int len = 0);
-	Field *getNext();
-	void   setNext(Field * fp);
+	void   setRawData(char *dp, int len, char **dpos, int nd,
+			  const unsigned char *codes = NULL);
 	void   setTag(char *tp, int len = 3);
 	char  *getTag();
 	char	getInd1();
 	char	getInd2();
 	int	isControlField();
-	void	print(std::ostream& os);
-	void	printXML(std::ostream& os, int indent);
+	int	isModified();
+	int	getSubFieldCount();
+	SubField *getSubField(int j);
+	SubField *findSubField(char code, int n = 0);
+	void	print(OutSink& os);
+	void	printXML(OutSink& os, int indent);
 	void	deleteControlCharacters();
   private:
 	char	ftag[4];
-	long	flength;
-	long	foffset;
-	char	*fdata;
-	int	fieldType;
-	Field	*next;
+	char	fieldType;	// 0: undefined, 1: data-field, 2: control-field //
 	char	ind1;
 	char	ind2;
-	int	isValidLength;
-	std::vector<SubField*>	subfields;
-	void	parseSubFields(char*, int, char);
+	char	isValidLength;
+	int	flength;
+	int	foffset;
+	char	*fdata;	// field data: view on the record or private copy //
+	SubField *subfields;	// array of sfcount subfields //
+	int	sfcount;
+	char	fowned;		// fdata is a private copy //
+	char	fpartial;	// only some subfields were extracted //
+	Arena	*arena;		// owner of data and subfields; NULL: heap //
+	char   *allocData(int len);
+	SubField *allocSubFields(int n);
+	void	parseSubFields(char*, int, char, const unsigned char*);
+	void	parseSubFields(char*, int, char**, int, const unsigned char*);
 };
 
 #endif /* _FIELD_H_ */
@@ -0,0 +1,157 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cctype>
+#include	<cstring>
+
+#include "FieldFilter.h"
+
+
+FieldFilter::FieldFilter()
+{
+   memset(numsel, 0, sizeof(numsel));
+}
+
+
+int FieldFilter::isEmpty()
+{
+   return rules.empty();
+}
+
+
+//---------------------------------------------------------------------------------
+// parse(const char*)
+//
+// legge una lista di tag separati da virgole, ciascuno seguito dai codici
+// dei subfield da estrarre (nessun codice: tutto il campo); restituisce 0 se
+// la lista non e' valida
+//---------------------------------------------------------------------------------
+
+int FieldFilter::parse( const char *spec )
+{
+   const char *cp = spec;
+
+   while (*cp)
+   {
+      Rule r;
+      int  k;
+
+      for (k = 0 ; k < 3 ; ++k)
+      {
+         if ((cp[k] == '\0') || (cp[k] == ','))
+            return 0;
+         r.tag[k] = cp[k];
+      }
+      r.tag[3] = '\0';
+      cp += 3;
+
+      memset(r.codes, 0, sizeof(r.codes));
+      r.all = 1;
+      while (*cp && (*cp != ','))
+      {
+         unsigned char c = (unsigned char) *cp++;
+         r.codes[c >> 3] |= (1 << (c & 7));
+         r.all = 0;
+      }
+      if (*cp == ',')
+         ++cp;
+      rules.push_back(r);
+
+      // numeric tags matched by the rule: merge with earlier rules //
+      for (int t = 0 ; t < 1000 ; ++t)
+      {
+         char tt[3] = { (char)('0' + t / 100), (char)('0' + (t / 10) % 10), (char)('0' + t % 10) };
+         for (k = 0 ; k < 3 ; ++k)
+            if ((r.tag[k] != 'X') && (r.tag[k] != 'x') && (r.tag[k] != tt[k]))
+               break;
+         if (k == 3)
+            mergeRule(t, r);
+      }
+   }
+   return ! rules.empty();
+}
+
+
+int FieldFilter::mergeRule( int t, const Rule &r )
+{
+   if (numsel[t] == 0)
+   {
+      merged.push_back(r);
+      numsel[t] = merged.size();
+      return numsel[t];
+   }
+
+   // each tag has its own merged rule //
+   Rule &m = merged[numsel[t] - 1];
+   m.all |= r.all;
+   for (int k = 0 ; k < 32 ; ++k)
+      m.codes[k] |= r.codes[k];
+   return numsel[t];
+}
+
+
+const FieldFilter::Rule * FieldFilter::findRule( const char *tag )
+{
+   if (isdigit((unsigned char) tag[0]) && isdigit((unsigned char) tag[1]) &&
+       isdigit((unsigned char) tag[2]))
+   {
+      int t = (tag[0] - '0') * 100 + (tag[1] - '0') * 10 + (tag[2] - '0');
+      return (numsel[t] != 0) ? &merged[numsel[t] - 1] : NULL;
+   }
+
+   // non numeric tag: first matching rule //
+   for (unsigned int j = 0 ; j < rules.size() ; ++j)
+   {
+      int k;
+      for (k = 0 ; k < 3 ; ++k)
+         if ((rules[j].tag[k] != 'X') && (rules[j].tag[k] != 'x') && (rules[j].tag[k] != tag[k]))
+            break;
+      if (k == 3)
+         return &rules[j];
+   }
+   return NULL;
+}
+
+
+int FieldFilter::selectsTag( const char *tag )
+{
+   return (findRule(tag) != NULL);
+}
+
+
+//---------------------------------------------------------------------------------
+// getCodes(const char*)
+//
+// bitmap (256 bit) dei codici di subfield selezionati per il tag; NULL se il
+// campo va preso per intero (o non e' selezionato)
+//---------------------------------------------------------------------------------
+
+const unsigned char * FieldFilter::getCodes( const char *tag )
+{
+   const Rule *r = findRule(tag);
+   return ((r == NULL) || r->all) ? NULL : r->codes;
+}
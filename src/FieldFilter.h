@@ -0,0 +1,63 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _FIELDFILTER_H_
+#define _FIELDFILTER_H_
+
+#include	<vector>
+
+
+/*
+ * FieldFilter: field projection given as a list of tags, tag groups and
+ * optional subfield codes, e.g. "001,200a,7XX" or "200ae,70X".
+ * 'X' (or 'x') in a tag matches any character.  A tag without codes
+ * selects the whole field; with codes only those subfields are kept.
+ */
+class FieldFilter
+{
+  public:
+	FieldFilter();
+	int	parse( const char *spec );
+	int	isEmpty();
+	int	selectsTag( const char *tag );
+	const unsigned char *getCodes( const char *tag );
+
+  private:
+	struct Rule
+	{
+		char		tag[4];
+		unsigned char	codes[32];	// bitmap of selected codes //
+		int		all;		// no codes given: whole field //
+	};
+	std::vector<Rule>	rules;
+	short	numsel[1000];	// numeric tag -> merged rule + 1, 0: not selected //
+	std::vector<Rule>	merged;
+	int	mergeRule( int t, const Rule &r );
+	const Rule *findRule( const char *tag );
+};
+
+#endif /* _FIELDFILTER_H_ */
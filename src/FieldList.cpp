@@ -25,6 +25,9 @@
  *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
  **************************************************************************/
 
+#include <cstdlib>
+#include <cstring>
+#include <new>
 
 #include "Field.h"
 #include "FieldList.h"
@@ -32,62 +35,100 @@
 
 FieldList::FieldList()
 {
-   first = last = NULL;
+   entries = NULL;
+   fields  = NULL;
+   count   = cap = 0;
 }
 
 FieldList::~FieldList()
 {
    clear();
+   free(entries);
+   free(fields);
 }
 
 int FieldList::isEmpty()
 {
-   return (first == NULL);
+   return (count == 0);
 }
 
 int FieldList::getCount()
 {
-   int cnt = 0;
-   Field *fp = first;
-   while (fp)
-   {
-      ++cnt;
-      fp = fp->getNext();
-   }
-   return cnt;
+   return count;
 }
 
-Field * FieldList::getFirst()
+DirEntry * FieldList::getEntry(int j)
 {
-   return first;
+   return ((j >= 0) && (j < count)) ? entries + j : NULL;
 }
 
-Field * FieldList::getLast()
+
+// field built for entry j, NULL if not built yet (or no such entry) //
+Field * FieldList::get(int j)
 {
-   return last;
+   return ((j >= 0) && (j < count)) ? fields[j] : NULL;
 }
 
-void FieldList::add(Field *fld)
+void FieldList::set(int j, Field *fp)
 {
-   if (last == NULL)
-      first = last = fld;
-   else
-   {
-      last->setNext(fld);
-      last = fld;
-   }
+   fields[j] = fp;
 }
 
-void FieldList::clear()
+
+//---------------------------------------------------------------------------------
+// reserve(int)
+//
+// garantisce spazio per almeno n voci; quelle esistenti vengono copiate nei
+// nuovi array
+//---------------------------------------------------------------------------------
+
+void FieldList::reserve(int n)
 {
-   Field *fp,*fpn;
-   fp = first;
-   while (fp != NULL)
-   {
-      fpn = fp->getNext();
-      delete fp;
-      fp = fpn;
-   }
-   first = last = NULL;
+   if (n <= cap)
+      return;
+   if (n < 2 * cap)
+      n = 2 * cap;
+
+   DirEntry *ne = (DirEntry*) realloc(entries, n * sizeof(DirEntry));
+   if (ne == NULL)
+      throw std::bad_alloc();
+   entries = ne;
+   Field **nf = (Field**) realloc(fields, n * sizeof(Field*));
+   if (nf == NULL)
+      throw std::bad_alloc();
+   fields = nf;
+   cap    = n;
 }
 
+
+//---------------------------------------------------------------------------------
+// add(const char*, long, long)
+//
+// aggiunge una voce con tag (3 caratteri), lunghezza dei dati (FT escluso)
+// e offset; la posizione dei dati nel record resta da trovare (pos = -1)
+//---------------------------------------------------------------------------------
+
+DirEntry * FieldList::add(const char *tag, long len, long offs)
+{
+   if (count == cap)
+      reserve((cap > 0) ? 2 * cap : 64);
+
+   DirEntry *e = entries + count;
+   memcpy(e->tag, tag, 3);
+   e->type   = ((tag[0] == '0') && (tag[1] == '0')) ? 2 : 1;
+   e->length = len;
+   e->offset = offs;
+   e->pos    = -1;
+   fields[count++] = NULL;
+   return e;
+}
+
+
+// fields live in the record arena: they are only destroyed here //
+void FieldList::clear()
+{
+   for (int j = 0 ; j < count ; ++j)
+      if (fields[j] != NULL)
+         fields[j]->~Field();
+   count = 0;
+}
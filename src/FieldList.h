@@ -31,6 +31,28 @@
 #include	"Field.h"
 
 
+/*
+ * DirEntry: one entry of the record directory, as read from the record.
+ * The tag is the 3 bytes of the directory, not terminated by '\0'.
+ */
+struct DirEntry
+{
+	char	tag[3];
+	char	type;		// 1: data-field, 2: control-field (as Field) //
+	int	length;		// field data length, FT excluded //
+	int	offset;		// offset of the field from the base address //
+	int	pos;		// field data position in the record, -1: not found //
+};
+
+
+/*
+ * FieldList: the record directory, kept as one contiguous array of
+ * compact DirEntry items.  The Field objects, with their subfields, are
+ * built only when a field is accessed and cached next to the entries
+ * (get/set).  The arrays are reused from record to record: clear() only
+ * resets the count, so a steady stream of records does not allocate.
+ * Entries are accessed by index: 0 .. getCount()-1.
+ */
 class FieldList
 {
   public:
@@ -38,14 +60,18 @@ class FieldList
 	~FieldList();
 	int     isEmpty();
 	int     getCount();
-	void    add(Field *fld);
+	void    reserve(int n);
+	DirEntry *add(const char *tag, long len, long offs);
 	void    clear();
-	Field * getFirst();
-	Field * getLast();
+	DirEntry *getEntry(int j);
+	Field * get(int j);
+	void    set(int j, Field *fp);
 
   private:
-	Field	*first;
-	Field	*last;
+	DirEntry *entries;	// contiguous array of entries //
+	Field	**fields;	// field built for each entry, NULL: not yet //
+	int	count;		// entries in use //
+	int	cap;		// allocated entries //
 };
 
 #endif /* _FIELDLIST_H_ */
@@ -0,0 +1,262 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cerrno>
+#include	<cstdio>
+#include	<cstdlib>
+#include	<fcntl.h>
+#include	<unistd.h>
+
+#include "FileSplitter.h"
+#include "OutSink.h"
+#include "Compressor.h"
+
+
+FileSplitter::FileSplitter( const char *p, long mr, long mb )
+{
+   path     = p;
+   maxrecs  = mr;
+   maxbytes = mb;
+   header   = NULL;
+   footer   = NULL;
+   zformat  = Compressor::NONE;
+   zthreads = 1;
+   sink     = NULL;
+   zout     = NULL;
+   fd       = -1;
+   nrecs    = 0;
+   err      = 0;
+}
+
+
+FileSplitter::~FileSplitter()
+{
+   delete sink;
+   delete zout;
+}
+
+
+void FileSplitter::setDecoration( Decoration hdr, Decoration ftr )
+{
+   header = hdr;
+   footer = ftr;
+}
+
+
+void FileSplitter::setCompression( int format, int nthreads )
+{
+   zformat  = format;
+   zthreads = nthreads;
+}
+
+
+int FileSplitter::getError()
+{
+   return err;
+}
+
+
+//---------------------------------------------------------------------------------
+// parseSize(const char*)
+//
+// dimensione in byte, con suffisso k, m o g opzionale (es. 512m);
+// -1 se non valida
+//---------------------------------------------------------------------------------
+
+long FileSplitter::parseSize( const char *spec )
+{
+   char *ep;
+   long n = strtol(spec, &ep, 10);
+
+   if ((ep == spec) || (n <= 0))
+      return -1;
+   switch (*ep)
+   {
+      case 'k': case 'K': n <<= 10; ++ep; break;
+      case 'm': case 'M': n <<= 20; ++ep; break;
+      case 'g': case 'G': n <<= 30; ++ep; break;
+   }
+   return (*ep == '\0') ? n : -1;
+}
+
+
+// name of the n-th file: number before the extension of the output-file //
+std::string FileSplitter::fileName( int n )
+{
+   char num[16];
+   size_t slash = path.rfind('/');
+   size_t dot   = path.find('.', (slash == std::string::npos) ? 0 : slash + 1);
+
+   snprintf(num, sizeof(num), "-%05d", n);
+   if (dot == std::string::npos)
+      return path + num;
+   return path.substr(0, dot) + num + path.substr(dot);
+}
+
+
+//---------------------------------------------------------------------------------
+// open()
+//
+// apre il primo file e restituisce il sink su cui scrivere tutti i record;
+// NULL se il file non puo' essere creato
+//---------------------------------------------------------------------------------
+
+OutSink *FileSplitter::open()
+{
+   if (! openFile())
+      return NULL;
+   return sink;
+}
+
+
+int FileSplitter::openFile()
+{
+   std::string name = fileName(names.size() + 1);
+
+   fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (fd < 0)
+   {
+      if (err == 0)
+         err = errno;
+      return 0;
+   }
+   if (sink == NULL)
+   {
+      sink = new OutSink(fd);
+      sink->setSplitter(this);
+   }
+   else
+      sink->reopen(fd);
+
+   if (zformat != Compressor::NONE)
+   {
+      zout = new Compressor();
+      if (! zout->open(fd, zformat, zthreads))
+      {
+         delete zout;
+         zout = NULL;
+         if (err == 0)
+            err = EINVAL;
+         return 0;
+      }
+      sink->setCompressor(zout);
+   }
+
+   names.push_back(name);
+   counts.push_back(0);
+   sizes.push_back(0);
+   nrecs = 0;
+   if (header != NULL)
+      header(sink);
+   return 1;
+}
+
+
+void FileSplitter::closeFile()
+{
+   if (footer != NULL)
+      footer(sink);
+   if (! sink->flush() && (err == 0))
+      err = sink->getError();
+   sizes.back()  = sink->tell();
+   counts.back() = nrecs;
+   if (zout != NULL)
+   {
+      if (! zout->finish() && (err == 0))
+         err = zout->getError();
+      sink->setCompressor(NULL);
+      delete zout;
+      zout = NULL;
+   }
+   ::close(fd);
+   fd = -1;
+}
+
+
+//---------------------------------------------------------------------------------
+// endRecord(OutSink&)
+//
+// chiamata dal sink alla fine di ogni record: raggiunto uno dei limiti
+// chiude il file corrente e apre il successivo
+//---------------------------------------------------------------------------------
+
+void FileSplitter::endRecord( OutSink &os )
+{
+   ++nrecs;
+   if (fd < 0)
+      return;   // a file could not be opened: error already recorded //
+   if (((maxrecs > 0) && (nrecs >= maxrecs)) || ((maxbytes > 0) && (os.tell() >= maxbytes)))
+   {
+      closeFile();
+      openFile();
+   }
+}
+
+
+//---------------------------------------------------------------------------------
+// close()
+//
+// chiude l'ultimo file (eliminandolo se e' rimasto vuoto perche' l'input e'
+// finito al limite del precedente) e scrive il manifest; restituisce 0 in
+// caso di errore (vedi getError())
+//---------------------------------------------------------------------------------
+
+int FileSplitter::close()
+{
+   if (fd >= 0)
+   {
+      closeFile();
+      if ((counts.size() > 1) && (counts.back() == 0))
+      {
+         unlink(names.back().c_str());
+         names.pop_back();
+         counts.pop_back();
+         sizes.pop_back();
+      }
+   }
+
+   std::string mname = path + ".manifest";
+   int mfd = ::open(mname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (mfd < 0)
+   {
+      if (err == 0)
+         err = errno;
+      return 0;
+   }
+   OutSink mf(mfd);
+   char line[64];
+   for (size_t j = 0 ; j < names.size() ; ++j)
+   {
+      mf.write(names[j].data(), names[j].size());
+      int n = snprintf(line, sizeof(line), "\t%ld\t%ld\n", counts[j], sizes[j]);
+      mf.write(line, n);
+   }
+   if (! mf.flush() && (err == 0))
+      err = mf.getError();
+   ::close(mfd);
+   return (err == 0);
+}
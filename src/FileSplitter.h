@@ -0,0 +1,85 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _FILESPLITTER_H_
+#define _FILESPLITTER_H_
+
+#include	<string>
+#include	<vector>
+
+class OutSink;
+class Compressor;
+
+
+/*
+ * FileSplitter: rolling output files (--split-records, --split-bytes).
+ * The records of one output go to a sequence of files named after the
+ * output-file with a number before the extension (out.xml -> out-00001.xml,
+ * out-00002.xml, ...).  A file is closed at the end of the record that
+ * reaches the record or byte limit; each file gets its own header and
+ * footer (an XML collection), so every file is valid on its own.
+ * close() writes the manifest, output-file + ".manifest", with one line
+ * per file: name, number of records and bytes (before compression).
+ */
+class FileSplitter
+{
+  public:
+	typedef void (*Decoration)( OutSink *os );
+
+	FileSplitter( const char *path, long maxrecs, long maxbytes );
+	~FileSplitter();
+	void	setDecoration( Decoration header, Decoration footer );
+	void	setCompression( int format, int nthreads );
+	OutSink	*open();
+	void	endRecord( OutSink &os );
+	int	close();
+	int	getError();
+	static long parseSize( const char *spec );
+
+  private:
+	int	openFile();
+	void	closeFile();
+	std::string fileName( int n );
+
+	std::string	path;
+	long	maxrecs;		// 0: no limit //
+	long	maxbytes;		// 0: no limit //
+	Decoration	header;
+	Decoration	footer;
+	int	zformat;
+	int	zthreads;
+	OutSink	*sink;
+	Compressor	*zout;
+	int	fd;
+	long	nrecs;			// records in the current file //
+	std::vector<std::string> names;	// files written so far //
+	std::vector<long>	counts;
+	std::vector<long>	sizes;
+	int	err;			// errno of the first failure //
+};
+
+#endif /* _FILESPLITTER_H_ */
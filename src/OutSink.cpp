@@ -0,0 +1,421 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstdlib>
+#include	<cstring>
+#include	<cerrno>
+#include	<new>
+#include	<unistd.h>
+#include	<sys/uio.h>
+
+#include "OutSink.h"
+#include "Compressor.h"
+#include "FileSplitter.h"
+#include "RunStats.h"
+#include "scanutils.h"
+
+
+#define MEMSINK_SIZE	(64 * 1024)	// initial size of a memory sink //
+
+
+OutSink::OutSink()
+{
+   fd  = -1;
+   err = 0;
+   zout = NULL;
+   split = NULL;
+   stats = NULL;
+   keepmarks = 0;
+   written = 0;
+   len = 0;
+   cap = MEMSINK_SIZE;
+   buf = (char*) malloc(cap);
+   if (buf == NULL)
+      throw std::bad_alloc();
+}
+
+
+OutSink::OutSink( int ofd, long bufsize )
+{
+   fd  = ofd;
+   err = 0;
+   zout = NULL;
+   split = NULL;
+   stats = NULL;
+   keepmarks = 0;
+   written = 0;
+   len = 0;
+   cap = (bufsize < 4096) ? 4096 : bufsize;
+   buf = (char*) malloc(cap);
+   if (buf == NULL)
+      throw std::bad_alloc();
+}
+
+
+OutSink::~OutSink()
+{
+   if (fd >= 0)
+      flush();
+   free(buf);
+}
+
+
+//---------------------------------------------------------------------------------
+// writeAll()
+//
+// scrive p1 e p2 con writeFile(), misurandone il tempo se e' stato
+// indicato un RunStats (--stats); restituisce 0 in caso di errore
+//---------------------------------------------------------------------------------
+
+int OutSink::writeAll( const char *p1, long n1, const char *p2, long n2 )
+{
+   if (stats == NULL)
+      return writeFile(p1, n1, p2, n2);
+
+   RunStats::Stamp st;
+   stats->start(st);
+   int r = writeFile(p1, n1, p2, n2);
+   stats->stop(RunStats::WRITE, st);
+   stats->addOutput(n1 + n2);
+   return r;
+}
+
+
+//---------------------------------------------------------------------------------
+// writeFile()
+//
+// scrive p1 e p2 sul file con un'unica writev, ripetendola finche' tutto
+// e' stato scritto (o li passa al Compressor); restituisce 0 in caso di errore
+//---------------------------------------------------------------------------------
+
+int OutSink::writeFile( const char *p1, long n1, const char *p2, long n2 )
+{
+   struct iovec iov[2];
+   int niov = 0;
+
+   if (zout != NULL)
+   {
+      if (! zout->write(p1, n1) || ! zout->write(p2, n2))
+      {
+         if (err == 0)
+            err = zout->getError();
+         return 0;
+      }
+      return 1;
+   }
+
+   if (n1 > 0)
+   {
+      iov[niov].iov_base = (void*) p1;
+      iov[niov].iov_len  = n1;
+      ++niov;
+   }
+   if (n2 > 0)
+   {
+      iov[niov].iov_base = (void*) p2;
+      iov[niov].iov_len  = n2;
+      ++niov;
+   }
+
+   struct iovec *ip = iov;
+   while (niov > 0)
+   {
+      ssize_t w = writev(fd, ip, niov);
+      if (w < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         if (err == 0)
+            err = errno;
+         return 0;
+      }
+      while ((niov > 0) && ((size_t) w >= ip->iov_len))
+      {
+         w -= ip->iov_len;
+         ++ip;
+         --niov;
+      }
+      if (niov > 0)
+      {
+         ip->iov_base = (char*) ip->iov_base + w;
+         ip->iov_len -= w;
+      }
+   }
+   return 1;
+}
+
+
+//---------------------------------------------------------------------------------
+// overflow(long)
+//
+// fa posto per altri n byte: svuota il buffer di un file sink, oppure
+// ingrandisce quello di un memory sink
+//---------------------------------------------------------------------------------
+
+void OutSink::overflow( long n )
+{
+   if ((fd >= 0) && (n <= cap))
+   {
+      flush();
+      return;
+   }
+
+   long ncap = cap;
+   while (ncap - len < n)
+      ncap *= 2;
+   char *nb = (char*) realloc(buf, ncap);
+   if (nb == NULL)
+      throw std::bad_alloc();
+   buf = nb;
+   cap = ncap;
+}
+
+
+void OutSink::writeLong( const char *p, long n )
+{
+   if (fd >= 0)
+   {
+      if (n < cap)
+      {
+         flush();
+         memcpy(buf, p, n);
+         len = n;
+      }
+      else
+      {
+         // larger than the buffer: pending data and p in one call //
+         writeAll(buf, len, p, n);
+         written += len + n;
+         len = 0;
+      }
+      return;
+   }
+   overflow(n);
+   memcpy(buf + len, p, n);
+   len += n;
+}
+
+
+void OutSink::puts( const char *s )
+{
+   write(s, strlen(s));
+}
+
+
+void OutSink::spaces( int n )
+{
+   static const char space[] = "                                        "; // 40 spaces //
+
+   while (n > 0)
+   {
+      int k = (n > 40) ? 40 : n;
+      write(space, k);
+      n -= k;
+   }
+}
+
+
+//---------------------------------------------------------------------------------
+// writeXML(const char*, long, int)
+//
+// scrive n byte di testo sostituendo '<', '>' e '&' con le entity XML, e
+// anche '"' se attr (valore di un attributo). I tratti senza caratteri
+// speciali sono copiati in blocco; quelli lunghi sono cercati con
+// scanutils::findXMLSpecial, quelli brevi (quasi tutti i subfield) byte per byte
+//---------------------------------------------------------------------------------
+
+void OutSink::writeXML( const char *p, long n, int attr )
+{
+   const char *ep = p + n;
+   const char *sp = p;   // start of the pending plain run //
+   const char q = attr ? '"' : '&';   // '&' is special anyway //
+
+   while (p < ep)
+   {
+      if (ep - p >= 32)
+      {
+         p += scanutils::findXMLSpecial(p, ep - p, attr);
+         if (p == ep)
+            break;
+      }
+      else
+      {
+         while ((p < ep) && (*p != '&') && (*p != '<') && (*p != '>') && (*p != q))
+            ++p;
+         if (p == ep)
+            break;
+      }
+      write(sp, p - sp);
+      switch (*p)
+      {
+         case '<': write("&lt;", 4);   break;
+         case '>': write("&gt;", 4);   break;
+         case '&': write("&amp;", 5);  break;
+         case '"': write("&quot;", 6); break;
+      }
+      sp = ++p;
+   }
+   write(sp, p - sp);
+}
+
+
+//---------------------------------------------------------------------------------
+// append(const OutSink&)
+//
+// accoda il contenuto di un memory sink
+//---------------------------------------------------------------------------------
+
+void OutSink::append( const OutSink &mem )
+{
+   long from = 0;
+
+   for (size_t j = 0 ; j < mem.marks.size() ; ++j)
+   {
+      write(mem.buf + from, mem.marks[j] - from);
+      endRecord();
+      from = mem.marks[j];
+   }
+   write(mem.buf + from, mem.len - from);
+}
+
+
+//---------------------------------------------------------------------------------
+// setCompressor(Compressor*)
+//
+// d'ora in poi il buffer di un file sink viene compresso da z (aperto sullo
+// stesso file) invece di essere scritto; chiudere z dopo l'ultimo flush()
+//---------------------------------------------------------------------------------
+
+void OutSink::setCompressor( Compressor *z )
+{
+   flush();
+   zout = z;
+}
+
+
+void OutSink::setStats( RunStats *st )
+{
+   stats = st;
+}
+
+
+//---------------------------------------------------------------------------------
+// flush()
+//
+// scrive sul file i dati nel buffer; restituisce 0 se la scrittura e' fallita
+// (anche in precedenza). Per un memory sink non fa nulla
+//---------------------------------------------------------------------------------
+
+int OutSink::flush()
+{
+   if (fd < 0)
+      return 1;
+   if (len > 0)
+      writeAll(buf, len, NULL, 0);
+   written += len;
+   len = 0;
+   return (err == 0);
+}
+
+
+void OutSink::clear()
+{
+   len = 0;
+   marks.clear();
+}
+
+
+//---------------------------------------------------------------------------------
+// setSplitter(FileSplitter*) / keepMarks()
+//
+// con uno splitter, a ogni endRecord() il file sink puo' passare a un nuovo
+// file; un memory sink con keepMarks() ricorda invece la fine di ogni record
+// per ripeterla quando viene accodato (append) al file sink
+//---------------------------------------------------------------------------------
+
+void OutSink::setSplitter( FileSplitter *fs )
+{
+   split = fs;
+}
+
+
+void OutSink::keepMarks()
+{
+   keepmarks = 1;
+}
+
+
+int OutSink::isSplit() const
+{
+   return (split != NULL);
+}
+
+
+void OutSink::splitRecord()
+{
+   split->endRecord(*this);
+}
+
+
+//---------------------------------------------------------------------------------
+// reopen(int)
+//
+// dopo un flush() continua a scrivere su un altro file; il Compressor, se
+// presente, va sostituito dal chiamante con setCompressor()
+//---------------------------------------------------------------------------------
+
+void OutSink::reopen( int ofd )
+{
+   flush();
+   fd = ofd;
+   written = 0;
+}
+
+
+// bytes written since open or reopen(), including the buffered ones //
+long OutSink::tell() const
+{
+   return written + len;
+}
+
+
+const char *OutSink::getData() const
+{
+   return buf;
+}
+
+
+long OutSink::getLength() const
+{
+   return len;
+}
+
+
+int OutSink::getError()
+{
+   return err;
+}
@@ -0,0 +1,129 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _OUTSINK_H_
+#define _OUTSINK_H_
+
+#include	<cstring>
+#include	<vector>
+
+class Compressor;
+class FileSplitter;
+class RunStats;
+
+
+/*
+ * OutSink: buffered output for all formats (text, XML, ISO).
+ * A file sink collects output in a large buffer and flushes it with
+ * write(2); data larger than the buffer goes out with a single writev
+ * together with what is pending. A memory sink (no file descriptor)
+ * just grows, and is used by the pipeline workers to build a batch
+ * that the writer then appends to the file sink.  A file sink with a
+ * Compressor passes the buffer to it instead of writing the file.
+ * endRecord() marks the end of a record: a file sink with a FileSplitter
+ * may then go on in a new file, a memory sink that keeps marks records
+ * the position so that append() repeats the marks on the file sink.
+ */
+class OutSink
+{
+  public:
+	OutSink();				// memory sink //
+	OutSink( int fd, long bufsize = 256 * 1024 );	// file sink //
+	~OutSink();
+
+	inline void put( char c )
+	{
+		if (len == cap)
+			overflow(1);
+		buf[len++] = c;
+	}
+	inline void write( const char *p, long n )
+	{
+		if (n <= cap - len)
+		{
+			memcpy(buf + len, p, n);
+			len += n;
+		}
+		else
+			writeLong(p, n);
+	}
+	void	puts( const char *s );
+	void	spaces( int n );
+	void	writeXML( const char *p, long n, int attr = 0 );
+	inline void putAttr( char c )
+	{
+		if ((c == '"') || (c == '&') || (c == '<') || (c == '>'))
+			writeXML(&c, 1, 1);
+		else
+			put(c);
+	}
+	void	append( const OutSink &mem );
+	void	setCompressor( Compressor *z );
+	void	setSplitter( FileSplitter *fs );
+	void	setStats( RunStats *st );
+	void	keepMarks();
+	int	isSplit() const;
+	inline void endRecord()
+	{
+		if (split != NULL)
+			splitRecord();
+		else
+		if (keepmarks)
+			marks.push_back(len);
+	}
+	void	reopen( int fd );
+	long	tell() const;
+	int	flush();
+	void	clear();
+
+	const char *getData() const;
+	long	getLength() const;
+	int	getError();
+
+  private:
+	char	*buf;
+	long	len;
+	long	cap;
+	int	fd;		// -1 for a memory sink //
+	int	err;		// errno of the first failed write //
+	Compressor	*zout;	// compressed output (-z), NULL: plain //
+	FileSplitter	*split;	// rolling output files, NULL: one file //
+	RunStats	*stats;	// --stats: time and bytes of the writes //
+	int	keepmarks;
+	std::vector<long> marks;	// record ends in a memory sink //
+	long	written;	// bytes flushed from buf since open or reopen() //
+	void	splitRecord();
+	void	overflow( long n );
+	void	writeLong( const char *p, long n );
+	int	writeAll( const char *p1, long n1, const char *p2, long n2 );
+	int	writeFile( const char *p1, long n1, const char *p2, long n2 );
+
+	OutSink( const OutSink & );
+	OutSink &operator=( const OutSink & );
+};
+
+#endif /* _OUTSINK_H_ */
@@ -0,0 +1,145 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstdlib>
+#include	<cstring>
+
+#include "OutputRoute.h"
+
+
+OutputRoute::OutputRoute( int fmt, const char *p )
+{
+   format = fmt;
+   if (p != NULL)
+      path = p;
+}
+
+
+//---------------------------------------------------------------------------------
+// parseFormat(const char*)
+//
+// formato di un'uscita: "xml", "iso" o "text"; -1 se sconosciuto
+//---------------------------------------------------------------------------------
+
+int OutputRoute::parseFormat( const char *name )
+{
+   if (strcmp(name, "xml") == 0)
+      return XML;
+   if ((strcmp(name, "iso") == 0) || (strcmp(name, "mrc") == 0))
+      return ISO;
+   if ((strcmp(name, "text") == 0) || (strcmp(name, "txt") == 0))
+      return TEXT;
+   return -1;
+}
+
+
+int OutputRoute::getFormat() const
+{
+   return format;
+}
+
+
+const char *OutputRoute::getPath() const
+{
+   return path.empty() ? NULL : path.c_str();
+}
+
+
+//---------------------------------------------------------------------------------
+// parseRule(const char*)
+//
+// aggiunge le condizioni di una regola di instradamento (vedi OutputRoute.h);
+// restituisce 0 se la regola non e' valida
+//---------------------------------------------------------------------------------
+
+int OutputRoute::parseRule( const char *spec )
+{
+   const char *cp = spec;
+
+   while (*cp)
+   {
+      const char *ep = strchr(cp, ',');
+      std::string term(cp, (ep != NULL) ? ep - cp : strlen(cp));
+      Cond c;
+
+      c.pos    = -1;
+      c.negate = 0;
+      c.tag[0] = '\0';
+      if (term.compare(0, 5, "label") == 0)
+      {
+         char *np;
+         long n = strtol(term.c_str() + 5, &np, 10);
+         if ((np == term.c_str() + 5) || (*np != '=') || (n < 0) || (n >= LABELSIZE) || (np[1] == '\0'))
+            return 0;
+         c.pos   = n;
+         c.chars = np + 1;
+      }
+      else
+      {
+         const char *tp = term.c_str();
+         if (*tp == '!')
+         {
+            c.negate = 1;
+            ++tp;
+         }
+         if ((strncmp(tp, "has=", 4) != 0) || (strlen(tp + 4) != 3))
+            return 0;
+         memcpy(c.tag, tp + 4, 4);
+      }
+      conds.push_back(c);
+      cp += term.size();
+      if (*cp == ',')
+         ++cp;
+   }
+   return 1;
+}
+
+
+//---------------------------------------------------------------------------------
+// matches(RecordIso2709&)
+//
+// 1 se il record (gia' decodificato) va scritto su questa uscita
+//---------------------------------------------------------------------------------
+
+int OutputRoute::matches( RecordIso2709 &rec ) const
+{
+   const char *label = rec.getLabel();
+
+   for (size_t j = 0 ; j < conds.size() ; ++j)
+   {
+      const Cond &c = conds[j];
+      if (c.pos >= 0)
+      {
+         if ((label[c.pos] == '\0') || (c.chars.find(label[c.pos]) == std::string::npos))
+            return 0;
+      }
+      else
+      if ((rec.hasTag(c.tag) != 0) == c.negate)
+         return 0;
+   }
+   return 1;
+}
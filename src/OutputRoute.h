@@ -0,0 +1,74 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _OUTPUTROUTE_H_
+#define _OUTPUTROUTE_H_
+
+#include	<string>
+#include	<vector>
+
+#include	"RecordIso2709.h"
+
+
+/*
+ * OutputRoute: one output of a run (--out format:file) together with the
+ * rule that chooses the records written to it (--where).  A rule is a
+ * comma separated list of conditions, all of which must hold:
+ *   labelN=CHARS   label position N (0-23) is one of CHARS, e.g. label7=ms
+ *   has=TAG        the record has a field TAG ('X' matches any character)
+ *   !has=TAG       the record has no field TAG
+ * Fields are looked up in the record as read, also those left out by -f.
+ * An output without a rule gets all the records.
+ */
+class OutputRoute
+{
+  public:
+	static const int TEXT = 0;
+	static const int XML  = 1;
+	static const int ISO  = 2;
+
+	OutputRoute( int format = ISO, const char *path = NULL );
+	static int parseFormat( const char *name );
+	int	parseRule( const char *spec );
+	int	getFormat() const;
+	const char *getPath() const;
+	int	matches( RecordIso2709 &rec ) const;
+
+  private:
+	struct Cond
+	{
+		int		pos;		// label position, -1: field test //
+		std::string	chars;		// accepted label characters //
+		char		tag[4];
+		int		negate;		// !has= //
+	};
+	int		format;
+	std::string	path;
+	std::vector<Cond>	conds;
+};
+
+#endif /* _OUTPUTROUTE_H_ */
@@ -0,0 +1,417 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<iostream>
+#include	<sstream>
+#include	<string>
+#include	<vector>
+#include	<deque>
+#include	<map>
+#include	<thread>
+#include	<mutex>
+#include	<condition_variable>
+
+#include "Pipeline.h"
+
+
+#define BATCH_RECORDS	256		// records per batch //
+#define BATCH_BYTES	(1L << 20)	// max record data per batch //
+
+
+//---------------------------------------------------------------------------------
+// convertRecord()
+//
+// scrive il record decodificato una sola volta su ciascuna uscita (outs[j]
+// per opts.routes[j]) la cui regola lo seleziona; i record non validi vanno
+// nel file degli scarti. Gli errori del record vanno su log, con il numero
+// recno. Restituisce 1 per un record buono, 0 per uno scartato
+//---------------------------------------------------------------------------------
+
+// errors of rec from offset 'from' of its messages, followed by its number //
+static void logMessages( RecordIso2709 &rec, std::ostream &log, long recno, size_t from )
+{
+   const std::string &msg = rec.getMessages();
+   if (msg.size() > from)
+   {
+      log.write(msg.data() + from, msg.size() - from);
+      log << "[1] record number: " << recno << '\n';
+   }
+}
+
+
+int convertRecord( RecordIso2709 &rec, const ConvertOptions &opts,
+		   const std::vector<OutSink*> &outs, OutSink &scart, std::ostream &log,
+		   long recno )
+{
+   size_t logged = rec.getMessages().size();
+   logMessages(rec, log, recno, 0);
+   if (rec.getStatus() != RecordIso2709::OK)
+   {
+      log << "status: " <<  rec.getStatus() << '\n';
+      rec.print(scart); // records scartati in user readable format //
+      scart.put('\n');
+      return 0;
+   }
+
+   if (opts.delctl)
+   {
+      // delete chars 0x00 - 0x31 from data //
+      rec.deleteControlCharacters();
+   }
+
+   int ok = 1;
+   for (size_t j = 0 ; j < opts.routes.size() ; ++j)
+   {
+      const OutputRoute &rt = opts.routes[j];
+      if (! rt.matches(rec))
+         continue;
+      switch (rt.getFormat())
+      {
+         case OutputRoute::TEXT:
+                  rec.print(*outs[j]);
+                  break;
+         case OutputRoute::XML:
+                  rec.printXML(*outs[j], opts.indent);
+                  break;
+         default:
+                  if (! rec.write_iso(*outs[j]))
+                  {
+                     ok = 0;
+                     continue;
+                  }
+      }
+      outs[j]->endRecord();   // record boundary for --split-* //
+   }
+   if (! ok)
+   {
+      logMessages(rec, log, recno, logged);
+      rec.print(scart);
+      scart.put('\n');
+   }
+   return ok;
+}
+
+
+//---------------------------------------------------------------------------------
+
+namespace
+{
+
+struct Batch
+{
+   long			seq;
+   long			first;	// number of the first record, from 1 //
+   std::vector<char>	data;	// record copies, only for non mapped input //
+   std::vector<char*>	recp;
+   std::vector<long>	reco;	// offset of each record in data //
+   std::vector<long>	recl;
+   std::vector<OutSink*> out;	// memory sinks filled by the worker, one per output //
+   OutSink		scart;
+   std::string		log;
+   long			good;
+   long			bad;
+};
+
+
+struct Shared
+{
+   std::mutex			lock;
+   std::condition_variable	workcv;		// workers wait for batches //
+   std::condition_variable	donecv;		// writer waits for results //
+   std::condition_variable	spacecv;	// reader waits for free slots //
+   std::deque<Batch*>		work;
+   std::map<long,Batch*>	done;
+   int				inflight;
+   int				maxinflight;
+   long				produced;	// batches handed to workers //
+   int				eof;
+};
+
+
+void worker( Shared *sh, const ConvertOptions *opts, RunStats *stats )
+{
+   RecordIso2709 *rec = new RecordIso2709();
+   rec->setFieldFilter(opts->filter);
+   rec->setStats(stats);
+
+   for (;;)
+   {
+      Batch *bt;
+      {
+         std::unique_lock<std::mutex> lk(sh->lock);
+         while (sh->work.empty() && ! sh->eof)
+            sh->workcv.wait(lk);
+         if (sh->work.empty())
+            break;
+         bt = sh->work.front();
+         sh->work.pop_front();
+      }
+
+      std::ostringstream log;
+      int n = bt->recl.size();
+      for (int j = 0 ; j < n ; ++j)
+      {
+         rec->clear();
+         rec->parse(bt->recp[j], bt->recl[j]);
+         RunStats::Stamp st;
+         if (stats != NULL)
+            stats->start(st);
+         if (convertRecord(*rec, *opts, bt->out, bt->scart, log, bt->first + j))
+            ++bt->good;
+         else
+            ++bt->bad;
+         if (stats != NULL)
+            stats->stop(RunStats::SERIALIZE, st);
+      }
+      rec->clear();
+      bt->log   = log.str();
+      std::vector<char>().swap(bt->data);   // record data no longer needed //
+
+      {
+         std::lock_guard<std::mutex> lk(sh->lock);
+         sh->done[bt->seq] = bt;
+      }
+      sh->donecv.notify_one();
+   }
+   if (stats != NULL)
+      stats->addMallocs(rec->getMallocCount(), rec->getAllocCount());
+   delete rec;
+}
+
+
+void writer( Shared *sh, int ordered, const std::vector<OutSink*> *outs, OutSink *scart,
+	     std::ostream *log, long *total, long *good, long *bad, Progress *progress )
+{
+   long next = 0;
+
+   for (;;)
+   {
+      Batch *bt;
+      {
+         std::unique_lock<std::mutex> lk(sh->lock);
+         for (;;)
+         {
+            if (! sh->done.empty())
+            {
+               if (! ordered)
+                  break;
+               if (sh->done.begin()->first == next)
+                  break;
+            }
+            if (sh->eof && (next == sh->produced))
+               return;
+            sh->donecv.wait(lk);
+         }
+         bt = sh->done.begin()->second;
+         sh->done.erase(sh->done.begin());
+      }
+
+      for (size_t j = 0 ; j < outs->size() ; ++j)
+      {
+         (*outs)[j]->append(*bt->out[j]);
+         delete bt->out[j];
+      }
+      scart->append(bt->scart);
+      if (! bt->log.empty())
+         *log << bt->log;
+      *total += bt->recl.size();
+      *good  += bt->good;
+      *bad   += bt->bad;
+      if (progress != NULL)
+         progress->update(*total, *bad);
+      delete bt;
+      ++next;
+
+      {
+         std::lock_guard<std::mutex> lk(sh->lock);
+         --sh->inflight;
+      }
+      sh->spacecv.notify_one();
+   }
+}
+
+}//namespace//
+
+
+//---------------------------------------------------------------------------------
+
+Pipeline::Pipeline( int nw, int ord )
+{
+   nworkers = (nw < 1) ? 1 : nw;
+   ordered  = ord;
+   stats    = NULL;
+   progress = NULL;
+   total = good = bad = 0;
+}
+
+
+Pipeline::~Pipeline()
+{
+}
+
+
+//---------------------------------------------------------------------------------
+// setStats(RunStats*)
+//
+// misura le fasi della conversione (--stats): ogni worker e il thread che
+// legge l'input usano un proprio RunStats, sommato a st alla fine di run();
+// le scritture sono misurate dai file sink, se anche loro usano st
+//---------------------------------------------------------------------------------
+
+void Pipeline::setStats( RunStats *st )
+{
+   stats = st;
+}
+
+
+// records written and input offset of the last batch, for --progress-interval //
+void Pipeline::setProgress( Progress *pg )
+{
+   progress = pg;
+}
+
+
+void Pipeline::run( RecordIso2709 &input, const ConvertOptions &opts,
+		    const std::vector<OutSink*> &outs, OutSink &scart, std::ostream &log )
+{
+   Shared sh;
+   std::vector<std::thread> workers;
+   int mapped = input.isInputMapped();
+   RunStats readstats;
+   std::vector<RunStats> wstats((stats != NULL) ? nworkers : 0);
+
+   sh.inflight    = 0;
+   sh.maxinflight = 4 * nworkers;
+   sh.produced    = 0;
+   sh.eof         = 0;
+
+   for (int j = 0 ; j < nworkers ; ++j)
+      workers.push_back(std::thread(worker, &sh, &opts, (stats != NULL) ? &wstats[j] : NULL));
+   std::thread wrt(writer, &sh, ordered, &outs, &scart, &log, &total, &good, &bad, progress);
+
+   // stage 1: frame records and hand them out in batches //
+   Batch *bt = NULL;
+   long   bytes = 0;
+   long   nframed = 0;
+   char  *rp;
+   long   recsz;
+   int    more;
+
+   do
+   {
+      if (stats != NULL)
+      {
+         RunStats::Stamp st;
+         readstats.start(st);
+         more = input.frame(rp, recsz);
+         readstats.stop(RunStats::READ, st);
+      }
+      else
+         more = input.frame(rp, recsz);
+      if (more)
+      {
+         if (bt == NULL)
+         {
+            bt = new Batch();
+            bt->first = nframed + 1;
+            bt->good = bt->bad = 0;
+            for (size_t j = 0 ; j < outs.size() ; ++j)
+            {
+               bt->out.push_back(new OutSink());
+               if (outs[j]->isSplit())
+                  bt->out[j]->keepMarks();
+            }
+            bytes = 0;
+         }
+         if (mapped)
+            bt->recp.push_back(rp);   // view into the mapping //
+         else
+         {
+            bt->reco.push_back(bt->data.size());
+            bt->data.insert(bt->data.end(), rp, rp + recsz);
+         }
+         bt->recl.push_back(recsz);
+         bytes += recsz;
+         ++nframed;
+      }
+
+      if ((bt != NULL) &&
+          ((! more) || (bt->recl.size() >= BATCH_RECORDS) || (bytes >= BATCH_BYTES)))
+      {
+         if (! mapped)
+            for (int j = 0 ; j < (int) bt->reco.size() ; ++j)
+               bt->recp.push_back(&bt->data[0] + bt->reco[j]);
+
+         if (progress != NULL)
+            progress->setOffset(input.tell());
+         std::unique_lock<std::mutex> lk(sh.lock);
+         while (sh.inflight >= sh.maxinflight)
+            sh.spacecv.wait(lk);
+         bt->seq = sh.produced++;
+         ++sh.inflight;
+         sh.work.push_back(bt);
+         lk.unlock();
+         sh.workcv.notify_one();
+         bt = NULL;
+      }
+   }
+   while (more);
+
+   {
+      std::lock_guard<std::mutex> lk(sh.lock);
+      sh.eof = 1;
+   }
+   sh.workcv.notify_all();
+   sh.donecv.notify_all();
+
+   for (int j = 0 ; j < nworkers ; ++j)
+      workers[j].join();
+   wrt.join();
+
+   if (stats != NULL)
+   {
+      stats->merge(readstats);
+      for (int j = 0 ; j < nworkers ; ++j)
+         stats->merge(wstats[j]);
+   }
+}
+
+
+long Pipeline::getTotal()
+{
+   return total;
+}
+
+long Pipeline::getGood()
+{
+   return good;
+}
+
+long Pipeline::getBad()
+{
+   return bad;
+}
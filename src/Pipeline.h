@@ -0,0 +1,90 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include	<iostream>
+#include	<vector>
+
+#include	"RecordIso2709.h"
+#include	"OutSink.h"
+#include	"OutputRoute.h"
+#include	"RunStats.h"
+#include	"Progress.h"
+
+
+/*
+ * output options shared by the sequential loop and the pipeline workers
+ */
+struct ConvertOptions
+{
+	std::vector<OutputRoute> routes;	// outputs (-t, -x, --out), one sink each //
+	int	indent;		// -i : XML indent //
+	int	delctl;		// -k : delete control characters //
+	FieldFilter	*filter;	// -f : fields to output, NULL: all //
+};
+
+int convertRecord( RecordIso2709 &rec, const ConvertOptions &opts,
+		   const std::vector<OutSink*> &outs, OutSink &scart, std::ostream &log,
+		   long recno );
+
+
+/*
+ * Pipeline: multi-threaded conversion (-j N).
+ *   stage 1: the calling thread frames records (RecordIso2709::frame)
+ *            and groups them in batches;
+ *   stage 2: N workers parse and serialize the batches;
+ *   stage 3: a writer thread outputs the results, restoring input order
+ *            unless unordered output was requested.
+ * The number of batches in flight is bounded, so a slow output blocks
+ * the reader instead of buffering the whole input in memory.
+ */
+class Pipeline
+{
+  public:
+	Pipeline( int nworkers, int ordered );
+	~Pipeline();
+	void	setStats( RunStats *st );
+	void	setProgress( Progress *pg );
+	void	run( RecordIso2709 &input, const ConvertOptions &opts,
+		     const std::vector<OutSink*> &outs, OutSink &scart, std::ostream &log );
+	long	getTotal();
+	long	getGood();
+	long	getBad();
+
+  private:
+	int	nworkers;
+	int	ordered;
+	RunStats	*stats;		// --stats, NULL: not measured //
+	Progress	*progress;	// --progress-interval, NULL: none //
+	long	total;
+	long	good;
+	long	bad;
+};
+
+#endif /* _PIPELINE_H_ */
@@ -0,0 +1,240 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstdio>
+#include	<cstring>
+#include	<cerrno>
+#include	<ctime>
+#include	<chrono>
+
+#include "Progress.h"
+
+
+#define METRIC	"extractiso2709_"	// prefix of the Prometheus metrics //
+
+
+// Monotonic clock in seconds.
+static double now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+Progress::Progress( double ivl, FILE *lp, const char *p )
+{
+   interval = (ivl > 0) ? ivl : 10;
+   log = lp;
+   if (p != NULL)
+      path = p;
+   from = to = 0;
+   records  = 0;
+   bad      = 0;
+   offset   = -1;
+   stopping = 0;
+   started  = lasttime = now();
+   lastrecs = 0;
+   lastoffs = 0;
+   warned   = 0;
+}
+
+
+Progress::~Progress()
+{
+   stop();
+}
+
+
+void Progress::setRange( long f, long t )
+{
+   from = f;
+   to   = t;
+   lastoffs = f;
+}
+
+
+void Progress::start()
+{
+   started = lasttime = now();
+   reporter = std::thread(&Progress::run, this);
+}
+
+
+//---------------------------------------------------------------------------------
+// stop()
+//
+// ferma il thread; il file delle metriche viene riscritto un'ultima volta
+// con i valori finali
+//---------------------------------------------------------------------------------
+
+void Progress::stop()
+{
+   if (! reporter.joinable())
+      return;
+   {
+      std::lock_guard<std::mutex> lk(lock);
+      stopping = 1;
+   }
+   cv.notify_one();
+   reporter.join();
+   if (! path.empty())
+      report(1);
+}
+
+
+void Progress::run()
+{
+   std::unique_lock<std::mutex> lk(lock);
+   for (;;)
+   {
+      cv.wait_for(lk, std::chrono::duration<double>(interval));
+      if (stopping)
+         break;
+      lk.unlock();
+      report(0);
+      lk.lock();
+   }
+}
+
+
+//---------------------------------------------------------------------------------
+// report(int)
+//
+// legge i contatori e calcola la velocita' dall'ultimo report, la
+// percentuale e il tempo che manca (alla velocita' media dall'inizio)
+//---------------------------------------------------------------------------------
+
+void Progress::report( int done )
+{
+   long   recs = records.load(std::memory_order_relaxed);
+   long   badrecs = bad.load(std::memory_order_relaxed);
+   long   offs = offset.load(std::memory_order_relaxed);
+   double t    = now();
+   double dt   = t - lasttime;
+   double recrate  = (dt > 0) ? (recs - lastrecs) / dt : 0;
+   double byterate = ((dt > 0) && (offs >= 0)) ? (offs - lastoffs) / dt : 0;
+   double eta  = -1;
+
+   if ((to > from) && (offs >= from) && (offs > lastoffs) && (t > started))
+   {
+      double avg = (offs - from) / (t - started);
+      eta = (to - offs) / avg;
+   }
+   if (done)
+      eta = 0;
+
+   if (path.empty())
+      printLine(recs, badrecs, offs, recrate, byterate, eta);
+   else
+   if (! writeMetrics(recs, badrecs, offs, recrate, byterate, eta, done) && ! warned)
+   {
+      fprintf(log, "progress: cannot write %s: %s\n", path.c_str(), strerror(errno));
+      warned = 1;
+   }
+   lasttime = t;
+   lastrecs = recs;
+   if (offs >= 0)
+      lastoffs = offs;
+}
+
+
+void Progress::printLine( long recs, long badrecs, long offs, double recrate, double byterate, double eta )
+{
+   char pct[32] = "";
+   char left[32] = "";
+
+   if ((to > from) && (offs >= from))
+      snprintf(pct, sizeof(pct), " (%.1f%%)", 100.0 * (offs - from) / (to - from));
+   if (eta >= 0)
+      snprintf(left, sizeof(left), "  ETA %ld:%02ld:%02ld",
+               (long) eta / 3600, ((long) eta / 60) % 60, (long) eta % 60);
+   fprintf(log, "progress: %ld records  offset %ld%s  %.0f records/s  %.1f MB/s%s  bad %.2f%%\n",
+           recs, (offs < 0) ? 0L : offs, pct, recrate, byterate / 1e6, left,
+           (recs > 0) ? 100.0 * badrecs / recs : 0.0);
+}
+
+
+//---------------------------------------------------------------------------------
+// writeMetrics()
+//
+// riscrive il file per il textfile collector del node exporter: prima in
+// path.tmp, poi rename() sul nome definitivo. Restituisce 0 in caso di errore
+//---------------------------------------------------------------------------------
+
+int Progress::writeMetrics( long recs, long badrecs, long offs, double recrate, double byterate,
+			    double eta, int done )
+{
+   std::string tmp = path + ".tmp";
+   FILE *fp = fopen(tmp.c_str(), "w");
+   if (fp == NULL)
+      return 0;
+
+   fprintf(fp, "# HELP " METRIC "records_total Records read so far.\n"
+               "# TYPE " METRIC "records_total counter\n"
+               METRIC "records_total %ld\n", recs);
+   fprintf(fp, "# HELP " METRIC "bad_records_total Records written to the discard file.\n"
+               "# TYPE " METRIC "bad_records_total counter\n"
+               METRIC "bad_records_total %ld\n", badrecs);
+   fprintf(fp, "# HELP " METRIC "bad_ratio Fraction of bad records.\n"
+               "# TYPE " METRIC "bad_ratio gauge\n"
+               METRIC "bad_ratio %g\n", (recs > 0) ? (double) badrecs / recs : 0.0);
+   if (offs >= 0)
+      fprintf(fp, "# HELP " METRIC "input_offset_bytes Input offset of the last record read.\n"
+                  "# TYPE " METRIC "input_offset_bytes gauge\n"
+                  METRIC "input_offset_bytes %ld\n", offs);
+   if (to > from)
+   {
+      fprintf(fp, "# HELP " METRIC "input_size_bytes Bytes of input to convert.\n"
+                  "# TYPE " METRIC "input_size_bytes gauge\n"
+                  METRIC "input_size_bytes %ld\n", to - from);
+      fprintf(fp, "# HELP " METRIC "progress_ratio Fraction of the input converted.\n"
+                  "# TYPE " METRIC "progress_ratio gauge\n"
+                  METRIC "progress_ratio %g\n",
+              done ? 1.0 : (offs >= from) ? (double) (offs - from) / (to - from) : 0.0);
+   }
+   fprintf(fp, "# HELP " METRIC "records_per_second Records per second since the previous report.\n"
+               "# TYPE " METRIC "records_per_second gauge\n"
+               METRIC "records_per_second %.1f\n", recrate);
+   fprintf(fp, "# HELP " METRIC "input_bytes_per_second Input bytes per second since the previous report.\n"
+               "# TYPE " METRIC "input_bytes_per_second gauge\n"
+               METRIC "input_bytes_per_second %.0f\n", byterate);
+   if (eta >= 0)
+      fprintf(fp, "# HELP " METRIC "eta_seconds Estimated seconds to the end of the input.\n"
+                  "# TYPE " METRIC "eta_seconds gauge\n"
+                  METRIC "eta_seconds %.0f\n", eta);
+   fprintf(fp, "# HELP " METRIC "done 1 when the conversion has finished.\n"
+               "# TYPE " METRIC "done gauge\n"
+               METRIC "done %d\n", done);
+   fprintf(fp, "# HELP " METRIC "last_update_timestamp_seconds Time of this report.\n"
+               "# TYPE " METRIC "last_update_timestamp_seconds gauge\n"
+               METRIC "last_update_timestamp_seconds %ld\n", (long) time(NULL));
+
+   if ((fclose(fp) != 0) || (rename(tmp.c_str(), path.c_str()) != 0))
+      return 0;
+   return 1;
+}
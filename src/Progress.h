@@ -0,0 +1,93 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _PROGRESS_H_
+#define _PROGRESS_H_
+
+#include	<cstdio>
+#include	<atomic>
+#include	<string>
+#include	<mutex>
+#include	<thread>
+#include	<condition_variable>
+
+
+/*
+ * Progress: periodic report of a long conversion (--progress-interval).
+ * The converting thread only stores its counters (records, bad records,
+ * input offset) in relaxed atomics with update(); a reporter thread
+ * wakes every interval, reads them and prints a line on the stream given
+ * by the caller, or rewrites a Prometheus textfile-collector file (--progress-file).
+ * The file is written under a temporary name and renamed, so the node
+ * exporter never reads a partial file.  Percent done and ETA need the
+ * size of the input (setRange()), known only for a mapped file.
+ */
+class Progress
+{
+  public:
+	Progress( double interval, FILE *log, const char *path = NULL );
+	~Progress();
+	void	setRange( long from, long to );
+	void	start();
+	void	stop();
+	inline void update( long recs, long badrecs )
+	{
+		records.store(recs, std::memory_order_relaxed);
+		bad.store(badrecs, std::memory_order_relaxed);
+	}
+	inline void setOffset( long offs )
+	{
+		offset.store(offs, std::memory_order_relaxed);
+	}
+
+  private:
+	void	run();
+	void	report( int done );
+	void	printLine( long recs, long badrecs, long offs, double recrate, double byterate, double eta );
+	int	writeMetrics( long recs, long badrecs, long offs, double recrate, double byterate,
+			      double eta, int done );
+
+	double	interval;		// seconds //
+	FILE	*log;			// progress lines and textfile errors //
+	std::string	path;		// textfile, empty: lines on log //
+	long	from;			// input range, to <= from: unknown //
+	long	to;
+	std::atomic<long> records;
+	std::atomic<long> bad;
+	std::atomic<long> offset;	// input offset of the last record, -1: unknown //
+	std::thread	reporter;
+	std::mutex	lock;
+	std::condition_variable	cv;
+	int	stopping;
+	double	started;		// monotonic seconds //
+	double	lasttime;		// previous report //
+	long	lastrecs;
+	long	lastoffs;
+	int	warned;			// textfile error already printed //
+};
+
+#endif /* _PROGRESS_H_ */
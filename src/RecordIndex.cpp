@@ -0,0 +1,312 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstring>
+#include	<string>
+#include	<vector>
+#include	<algorithm>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+
+#include "RecordIndex.h"
+#include "RecordIso2709.h"
+#include "OutSink.h"
+#include "strutils.h"
+
+
+#define INDEX_MAGIC	"ISO2709X"
+#define INDEX_VERSION	2
+#define INDEX_BYTEORDER	0x01020304
+
+
+namespace
+{
+
+// build time (ordinal, control number) pair, sorted by control number //
+struct IdKey
+{
+   uint32_t	rec;
+   uint32_t	key;
+};
+
+struct IdLess
+{
+   const char *pool;
+   IdLess( const char *p ) : pool(p) {}
+   bool operator()( const IdKey &a, const IdKey &b ) const
+   {
+      int c = strcmp(pool + a.key, pool + b.key);
+      return (c < 0) || ((c == 0) && (a.rec < b.rec));
+   }
+};
+
+
+//---------------------------------------------------------------------------------
+// controlNumber()
+//
+// cerca il campo 001 nella directory del record senza decodificarlo;
+// restituisce 0 se il record non ha un 001 leggibile
+//---------------------------------------------------------------------------------
+
+int controlNumber( char *rp, long len, const char *&id, long &idlen )
+{
+   if (len < LABELSIZE + 1)
+      return 0;
+
+   long data_offs = strutils::strntolong(rp + 12, 5);
+   int  flen = CTOI(rp[20]);
+   int  foff = CTOI(rp[21]);
+   int  esize = 3 + flen + foff;
+   if ((data_offs > len) || (flen == 0) || (foff == 0))
+      return 0;
+
+   for (char *bp = rp + LABELSIZE ; (bp + esize < rp + data_offs) && (*bp != FT) ; bp += esize)
+   {
+      if (memcmp(bp, "001", 3) != 0)
+         continue;
+      long l = strutils::strntolong(bp + 3, flen) - 1;   // without FT //
+      long o = strutils::strntolong(bp + 3 + flen, foff);
+      if ((l < 0) || (data_offs + o + l > len))
+         return 0;
+      id    = rp + data_offs + o;
+      idlen = l;
+      return 1;
+   }
+   return 0;
+}
+
+}//namespace//
+
+
+RecordIndex::RecordIndex()
+{
+   base    = NULL;
+   size    = 0;
+   hdr     = NULL;
+   offsets = NULL;
+   ids     = NULL;
+   pool    = NULL;
+}
+
+
+RecordIndex::~RecordIndex()
+{
+   close();
+}
+
+
+//---------------------------------------------------------------------------------
+// build(RecordReader&, const char*)
+//
+// scandisce l'input cercando solo i terminatori di record (e il 001 di ogni
+// record) e scrive l'indice in path. Restituisce il numero di record
+// indicizzati, -1 se l'indice non puo' essere scritto
+//---------------------------------------------------------------------------------
+
+long RecordIndex::build( RecordReader &input, const char *path )
+{
+   std::vector<uint64_t> offs;
+   std::vector<IdKey>    keys;
+   std::string           idpool;
+   char *rp;
+   long  len;
+
+   while (input.next(rp, len))
+   {
+      const char *id;
+      long idlen;
+      if (controlNumber(rp, len, id, idlen))
+      {
+         IdKey k;
+         k.rec = offs.size();
+         k.key = idpool.size();
+         idpool.append(id, idlen);
+         idpool.push_back('\0');
+         keys.push_back(k);
+      }
+      offs.push_back(input.tell());
+      if ((offs.size() > 0xFFFFFFFFUL) || (idpool.size() > 0xFFFFFFFFUL))
+         return -1;   // does not fit the 32 bit id table //
+   }
+   std::sort(keys.begin(), keys.end(), IdLess(idpool.data()));
+
+   int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (fd < 0)
+      return -1;
+
+   Header h;
+   memset(&h, 0, sizeof(h));
+   memcpy(h.magic, INDEX_MAGIC, sizeof(h.magic));
+   h.version   = INDEX_VERSION;
+   h.byteorder = INDEX_BYTEORDER;
+   h.filesize  = input.getSize();
+   h.mtime     = input.getModTime();
+   h.count     = offs.size();
+   h.nids      = keys.size();
+   h.poolsize  = idpool.size();
+
+   int ok;
+   {
+      OutSink out(fd);
+      out.write((const char*) &h, sizeof(h));
+      if (! offs.empty())
+         out.write((const char*) &offs[0], offs.size() * sizeof(uint64_t));
+      if (! keys.empty())
+         out.write((const char*) &keys[0], keys.size() * sizeof(IdKey));
+      out.write(idpool.data(), idpool.size());
+      ok = out.flush();
+   }
+   if ((::close(fd) != 0) || ! ok)
+      return -1;
+   return offs.size();
+}
+
+
+//---------------------------------------------------------------------------------
+// open(const char*)
+//
+// mappa in memoria un indice; restituisce 0 se il file manca, e' di un'altra
+// versione, e' troncato o rimanda fuori dalle sue tabelle
+//---------------------------------------------------------------------------------
+
+int RecordIndex::open( const char *path )
+{
+   struct stat st;
+
+   close();
+   int fd = ::open(path, O_RDONLY);
+   if (fd < 0)
+      return 0;
+   if ((fstat(fd, &st) != 0) || (st.st_size < (off_t) sizeof(Header)))
+   {
+      ::close(fd);
+      return 0;
+   }
+   void *mp = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if (mp == MAP_FAILED)
+      return 0;
+   base = (char*) mp;
+   size = st.st_size;
+
+   hdr = (const Header*) base;
+   if ((memcmp(hdr->magic, INDEX_MAGIC, sizeof(hdr->magic)) != 0) ||
+       (hdr->version != INDEX_VERSION) || (hdr->byteorder != INDEX_BYTEORDER) ||
+       (hdr->count > (uint64_t) size) || (hdr->nids > (uint64_t) size) ||
+       (sizeof(Header) + hdr->count * sizeof(uint64_t) + hdr->nids * sizeof(IdEntry)
+	+ hdr->poolsize != (uint64_t) size))
+   {
+      close();
+      return 0;
+   }
+   offsets = (const uint64_t*) (base + sizeof(Header));
+   ids     = (const IdEntry*) (offsets + hdr->count);
+   pool    = (const char*) (ids + hdr->nids);
+
+   // findId() runs strcmp on the pool: every id must start and end inside it //
+   if ((hdr->poolsize > 0) ? (pool[hdr->poolsize - 1] != '\0') : (hdr->nids > 0))
+   {
+      close();
+      return 0;
+   }
+   for (uint64_t k = 0 ; k < hdr->nids ; ++k)
+      if ((ids[k].key >= hdr->poolsize) || (ids[k].rec >= hdr->count))
+      {
+         close();
+         return 0;
+      }
+
+   madvise(base, size, MADV_RANDOM);
+   return 1;
+}
+
+
+void RecordIndex::close()
+{
+   if (base != NULL)
+      munmap(base, size);
+   base    = NULL;
+   size    = 0;
+   hdr     = NULL;
+   offsets = NULL;
+   ids     = NULL;
+   pool    = NULL;
+}
+
+
+// index built for a different file, or before the file was last changed //
+int RecordIndex::isStale( RecordReader &input )
+{
+   return (hdr == NULL) || (hdr->filesize != (uint64_t) input.getSize()) ||
+          (hdr->mtime != (uint64_t) input.getModTime());
+}
+
+
+long RecordIndex::getCount()
+{
+   return (hdr != NULL) ? hdr->count : 0;
+}
+
+
+// byte offset of record n (0 based), -1 if out of range //
+long RecordIndex::getOffset( long n )
+{
+   if ((hdr == NULL) || (n < 0) || ((uint64_t) n >= hdr->count))
+      return -1;
+   return offsets[n];
+}
+
+
+//---------------------------------------------------------------------------------
+// findId(const char*, std::vector<long>&)
+//
+// aggiunge a recs gli ordinali (da 0) dei record con 001 uguale a id, in
+// ordine di file; restituisce quanti ne ha trovati
+//---------------------------------------------------------------------------------
+
+int RecordIndex::findId( const char *id, std::vector<long> &recs )
+{
+   if (hdr == NULL)
+      return 0;
+
+   long lo = 0, hi = hdr->nids;
+   while (lo < hi)   // first entry not less than id //
+   {
+      long mid = lo + (hi - lo) / 2;
+      if (strcmp(pool + ids[mid].key, id) < 0)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   int n = 0;
+   for ( ; ((uint64_t) lo < hdr->nids) && (strcmp(pool + ids[lo].key, id) == 0) ; ++lo, ++n)
+      recs.push_back(ids[lo].rec);
+   return n;
+}
@@ -0,0 +1,90 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _RECORDINDEX_H_
+#define _RECORDINDEX_H_
+
+#include	<vector>
+#include	<stdint.h>
+
+#include	"RecordReader.h"
+
+
+/*
+ * RecordIndex: sidecar file for random access into an ISO 2709 file.
+ * It maps the record ordinal and the control number (field 001) of
+ * every record to its byte offset in the input, so single records can
+ * be converted without reading the whole file.
+ *
+ * File layout (host byte order, checked through 'byteorder'):
+ *	header
+ *	uint64_t	offsets[count]		byte offset of each record
+ *	IdEntry		ids[nids]		sorted by control number
+ *	char		pool[poolsize]		control numbers, '\0' terminated
+ */
+class RecordIndex
+{
+  public:
+	RecordIndex();
+	~RecordIndex();
+
+	static long build( RecordReader &input, const char *path );
+
+	int	open( const char *path );
+	void	close();
+	int	isStale( RecordReader &input );
+	long	getCount();
+	long	getOffset( long n );
+	int	findId( const char *id, std::vector<long> &recs );
+
+  private:
+	struct Header
+	{
+		char		magic[8];
+		uint32_t	version;
+		uint32_t	byteorder;
+		uint64_t	filesize;	// size of the indexed input //
+		uint64_t	mtime;		// its modification time, ns //
+		uint64_t	count;
+		uint64_t	nids;
+		uint64_t	poolsize;
+	};
+	struct IdEntry
+	{
+		uint32_t	rec;		// record ordinal //
+		uint32_t	key;		// offset of the control number in pool //
+	};
+
+	char		*base;		// mapped index file //
+	long		size;
+	const Header	*hdr;
+	const uint64_t	*offsets;
+	const IdEntry	*ids;
+	const char	*pool;
+};
+
+#endif /* _RECORDINDEX_H_ */
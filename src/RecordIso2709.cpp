@@ -26,25 +26,35 @@
  **************************************************************************/
 
 #include <iostream>
+#include <cctype>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <new>
 
 
+#include <algorithm>
+
 #include "RecordIso2709.h"
+#include "Directory.h"
 #include "strutils.h"
+#include "scanutils.h"
 
 
 using namespace std;
 
-extern void error(int , const char*);
-
 
 RecordIso2709::RecordIso2709()
 {
    fldterm = FT;   // initialize field terminator //
    recterm = RT;   // initialize record terminator //
    status   = OK;
+   inps     = NULL;
+   reader   = NULL;
+   filter   = NULL;
+   stats    = NULL;
+   rawrec   = NULL;
+   rawlen   = 0;
 }
 
 RecordIso2709::RecordIso2709( std::istream &input )
@@ -53,27 +63,109 @@ RecordIso2709::RecordIso2709( std::istream &input )
    recterm = RT;   // initialize record terminator //
    status  = OK;
    inps    = &input;
+   reader  = NULL;
+   filter  = NULL;
+   stats   = NULL;
+   rawrec  = NULL;
+   rawlen  = 0;
 }
 
 
 void RecordIso2709::setInputStream( std::istream &input )
 {
-    inps = &input;
+    inps   = &input;
+    reader = NULL;
+}
+
+
+void RecordIso2709::setInputReader( RecordReader &rdr )
+{
+    reader = &rdr;
+    inps   = NULL;
+}
+
+
+//---------------------------------------------------------------------------------
+// setFieldFilter(FieldFilter*)
+//
+// da qui in poi parse() decodifica solo i campi (e i subfield) selezionati;
+// NULL per tornare a leggere il record completo
+//---------------------------------------------------------------------------------
+
+void RecordIso2709::setFieldFilter( FieldFilter *flt )
+{
+    filter = (flt != NULL && ! flt->isEmpty()) ? flt : NULL;
+}
+
+
+void RecordIso2709::setStats( RunStats *st )
+{
+    stats = st;
+}
+
+
+int RecordIso2709::isInputMapped()
+{
+    return (reader != NULL) && reader->isMapped();
+}
+
+
+// input offset of the last record framed, -1 for an istream //
+long RecordIso2709::tell()
+{
+    return (reader != NULL) ? reader->tell() : -1;
 }
 
 
 int RecordIso2709::read()
 {
-   Field *fp;
-   int j,rl;
+   char *rp;
+   long recsz;
+
+   clear();
+   if (stats != NULL)
+   {
+      RunStats::Stamp st;
+      stats->start(st);
+      int r = frame(rp, recsz, (filter == NULL) ? &delims : NULL);
+      stats->stop(RunStats::READ, st);
+      if (! r)
+         return 0;
+   }
+   else
+   if (! frame(rp, recsz, (filter == NULL) ? &delims : NULL))
+      return 0;
+   return parse(rp, recsz);
+}
+
+
+//---------------------------------------------------------------------------------
+// frame(char*&, long&, std::vector<char*>*)
+//
+// individua il prossimo record in input senza decodificarlo: rp/recsz
+// puntano al record nel file mappato oppure in buf (lettura da stream) e
+// restano validi fino alla successiva chiamata di frame() o read().
+// Con input mappato, se pos non e' NULL vi vengono raccolte le posizioni dei
+// delimitatori, trovate insieme alla fine del record.
+// Restituisce 0 solo a fine input: un record con l'etichetta illeggibile
+// viene restituito comunque, e parse() lo segnala come BAD_LABEL
+//---------------------------------------------------------------------------------
+
+int RecordIso2709::frame(char *&rp, long &recsz, std::vector<char*> *pos)
+{
+   int rl;
    char ch;
    char *bp;
-   long len, data_offs;
-   int  direntry_size;
-   int  recsz;
+   long len;
+
+   // memory mapped input: record is a view into the mapping //
+   if (reader != NULL)
+   {
+      if (pos != NULL)
+         pos->clear();
+      return reader->next(rp, recsz, pos);
+   }
 
-   clear();
-   
    // read label //
    if ((*inps).eof())
       return 0;
@@ -88,16 +180,13 @@ int RecordIso2709::read()
 
    // get label //
    (*inps).get( buf, LABELSIZE + 1, RT );
+   if ((*inps).gcount() == 0)
+      return 0;   // end of input //
 
-   bp = buf;
-   for (int j = 0 ; j < LABELSIZE ; ++j)
-      label[j] = *bp++;
+   bp = buf + (*inps).gcount();
 
 #ifndef FORMAT_PATCH
-   if (strutils::hasIllegalCharacters(label))
-      status = BAD_LABEL;
-
-   len = strutils::strntolong(label,5);   // record length [0-4] //
+   len = strutils::strntolong(buf,5);   // record length [0-4] //
    if (len < LABELSIZE)
       return 0;
 
@@ -111,23 +200,17 @@ int RecordIso2709::read()
    
    if (buf[len-0] != RT)   // check record termination //
    {
-      cerr <<  "invalid RT: " << buf << '\n';
+      report((std::string("invalid RT: ") + buf).c_str());
       return 0;
    }
+   recsz = len;
 #endif
 
 
 #ifdef FORMAT_PATCH
-   if (strutils::hasIllegalCharacters(label))
-      status = BAD_LABEL;
-
-   len = strutils::strntolong(label,5);   // record length [0-4] //
-   if (len < LABELSIZE)
-      return 0;
-
    if ((*inps).eof())
    {
-      cerr <<  "unexpected end of file: \n";
+      report("unexpected end of file");
       return 0;
    }
 
@@ -140,74 +223,227 @@ int RecordIso2709::read()
    *bp = '\0';
 
    recsz = bp - buf ;
-   
-   if (len != recsz)
-   {
-      cerr <<  "invalid record length: " << len << " : " << recsz << '\n';
-      //cerr <<  "invalid record length: " << buf << '\n';
-      //status |= INVALID_RECORDLENGTH;
-      //return 1;
-   }
 #endif
 
-   data_offs  = strutils::strntolong(label+12,5);   // data offset  [12-17]
-   Dimpl_Flen = CTOI(*(label+20));      // dir. entry length indication [20] //
-   Dimpl_Foff = CTOI(*(label+21));      // dir. entry offset indication [21] //
+   rp = buf;
+   return 1;
+}
+
 
-   direntry_size = 3 + Dimpl_Flen + Dimpl_Foff;   // dir. entry size //
-   num_entries = (data_offs - LABELSIZE -1 ) / direntry_size; // number of dir entries //
+//---------------------------------------------------------------------------------
+// decodeDirectory<FL,FO>(Directory&)
+//
+// aggiunge a dir le voci della directory del record, saltando i campi non
+// selezionati dal filtro, e restituisce la lunghezza dei dati se i campi
+// fossero in sequenza. FL e FO sono le larghezze di lunghezza e offset note
+// a compilazione (0: quelle dell'etichetta). Una voce con caratteri non
+// numerici rende il record BAD_DIRECTORY (segnalata la prima); e' comunque
+// decodificata da strntolong, per mostrarla nei record scartati
+//---------------------------------------------------------------------------------
 
-   bp = buf + LABELSIZE ;
+template <int FL, int FO>
+long RecordIso2709::decodeDirectory( Directory &d )
+{
+   const char *bp = d.getEntries();
+   const int esize = d.getEntrySize();
+   long len, offs;
+   long seqlen = 0;
 
-   // parse dir entries //
-   for ( j = 0 ; j < num_entries ; ++j )
+   for (int j = 0 ; j < num_entries ; ++j, bp += esize)
    {
-      Field *fld = new Field();
-      dir.add(fld);
-      fld->setTag(bp,3);
-      bp += 3;
-      fld->setLength( strutils::strntolong(bp, Dimpl_Flen) - 1 );
-      bp += Dimpl_Flen;
-      fld->setOffset( strutils::strntolong(bp, Dimpl_Foff) );
-      bp += Dimpl_Foff;
+      if (d.entry<FL,FO>(bp, len, offs))
+      {
+         if (! (status & BAD_DIRECTORY))
+         {
+            char errmsg[200];
+            sprintf(errmsg, "ERROR: label = %s, non numeric directory entry %d: %.*s",
+                  label, j + 1, esize, bp);
+            report(errmsg);
+         }
+         status |= BAD_DIRECTORY;
+      }
+      if ((filter == NULL) || filter->selectsTag(bp))
+      {
+         dir.add(bp, len, offs);
+         seqoffs.push_back(seqlen);
+      }
+      seqlen += len + 1;
    }
+   return seqlen;
+}
 
-   // end of directory //
-   if (*bp++ != FT)
-      error(1 , "ERROR: on reading first field separator");
 
-   // read data for each entry //
-   fp = dir.getFirst();
-   while (fp)
+//---------------------------------------------------------------------------------
+// decode(char*, long)
+//
+// decodifica etichetta, directory e campi del record lungo 'recsz' byte che
+// inizia in 'rec'; il buffer non viene modificato e non deve essere terminato
+// da '\0' (puo' essere una vista sul file mappato in memoria)
+//---------------------------------------------------------------------------------
+
+int RecordIso2709::decode(char *rec, long recsz)
+{
+   Directory d;
+   DirEntry *ep0;
+   int j, num_fields;
+   char *bp, *ep;
+   const char *fdp;
+   long len, seqlen;
+
+   ep = rec + recsz;   // end of record data //
+   rawrec = rec;
+   rawlen = recsz;
+
+   // label checks and directory geometry, shared with RecordVisitor //
+   int ok = d.decode(rec, recsz, label, status, &messages);
+   Dimpl_Flen  = d.getLengthWidth();
+   Dimpl_Foff  = d.getOffsetWidth();
+   num_entries = d.getCount();
+   if (! ok)
+      return 1;
+
+   // delimiter positions, unless already found while framing the record; //
+   // with a field filter the selected fields are scanned one at a time  //
+   if (delims.empty() && (filter == NULL))
+      scanutils::scanDelimiters(rec, recsz, delims);
+
+   // parse dir entries: the 4/5 entry map of UNIMARC and MARC 21 has its //
+   // own decoder, any other map goes through the generic one            //
+   dir.reserve(num_entries);
+   seqoffs.clear();
+   if ((Dimpl_Flen == 4) && (Dimpl_Foff == 5))
+      seqlen = decodeDirectory<4,5>(d);
+   else
+      seqlen = decodeDirectory<0,0>(d);
+
+   buildTagIndex();
+
+   // end of directory //
+   if (d.getFields()[-1] != FT)
+      report("ERROR: on reading first field separator");
+
+   // locate the data of each entry: fields are found through the       //
+   // directory offsets; if the offset is wrong the field is expected     //
+   // right after the previous one, as in a sequential directory. The     //
+   // subfields are split later, when the field is used (field())        //
+   num_fields = dir.getCount();
+   for ( j = 0 ; j < num_fields ; ++j )
    {
-      fp->setRawData( bp, fp->getLength() );
-      bp += fp->getLength();
-      fp = fp->getNext();
-      if (*bp != FT)
+      ep0 = dir.getEntry(j);
+      len = ep0->length;
+      fdp = d.locate(len, ep0->offset, seqoffs[j]);
+      if (fdp == NULL)
       {
          char errmsg[200];
-         sprintf(errmsg,"ERROR: label = %s, error reading field separator: %c (%x)\n",
-               label, *bp, *bp);
-         cerr << errmsg;
+         char *sp = (char*) d.getFields() + seqoffs[j];
+         char ch = ((len >= 0) && (sp + len < ep)) ? sp[len] : 0;
+         if ((len > 0) && (sp + len <= ep))
+         {
+            // shown in the discarded records //
+            Field *fp = newField(ep0);
+            fp->setRawData( sp, len, NULL, -1 );
+            dir.set(j, fp);
+         }
+         // the byte in hex; a placeholder for it when it is not printable //
+         unsigned char uc = ch;
+         sprintf(errmsg,"ERROR: label = %s, error reading field separator: %c (%x)",
+               label, isprint(uc) ? uc : '?', uc);
+         report(errmsg);
          status |= ILLEGAL_FIELDSEP;
          return 1;
       }
-      ++bp;
+      ep0->pos = fdp - rec;
    }
 
-   if (*bp++ != RT)
-      error(1 , "ERROR: on reading record separator\n");
+   bp = (char*) d.getFields() + seqlen;
+   if ((bp >= ep) || (*bp != RT))
+      report("ERROR: on reading record separator");
 
    return  1;
 }
 
 
+//---------------------------------------------------------------------------------
+// field(int)
+//
+// campo j della directory, costruito nell'arena alla prima richiesta: i
+// subfield sono separati solo per i campi che vengono usati. Un campo che
+// decode() non ha trovato nel record ha solo tag, lunghezza e offset
+//---------------------------------------------------------------------------------
+
+Field * RecordIso2709::field( int j )
+{
+   Field *fp = dir.get(j);
+   if ((fp != NULL) || (j < 0) || (j >= dir.getCount()))
+      return fp;
+
+   DirEntry *e = dir.getEntry(j);
+   fp = newField(e);
+   if ((e->pos >= 0) && (e->length > 0))
+   {
+      char *fdp = rawrec + e->pos;
+      if (delims.empty())
+         fp->setRawData( fdp, e->length, NULL, -1,
+                         (filter != NULL) ? filter->getCodes(e->tag) : NULL );
+      else
+      {
+         // subfield delimiters inside this field //
+         std::vector<char*>::iterator d0, d1;
+         d0 = std::lower_bound(delims.begin(), delims.end(), fdp);
+         d1 = std::lower_bound(d0, delims.end(), fdp + e->length);
+         fp->setRawData( fdp, e->length, (d0 == d1) ? NULL : &*d0, d1 - d0 );
+      }
+   }
+   dir.set(j, fp);
+   return fp;
+}
+
+
+// Field for directory entry e, in the record arena, without data //
+Field * RecordIso2709::newField( DirEntry *e )
+{
+   Field *fp = new (arena.alloc(sizeof(Field))) Field(&arena);
+   fp->setTag(e->tag, 3);
+   fp->setLength(e->length);
+   fp->setOffset(e->offset);
+   return fp;
+}
+
+
+//---------------------------------------------------------------------------------
+// parse(char*, long)
+//
+// decodifica il record con decode(); con setStats() ne misura anche il
+// tempo e conta lunghezza, numero di campi e stato
+//---------------------------------------------------------------------------------
+
+int RecordIso2709::parse(char *rec, long recsz)
+{
+   if (stats == NULL)
+      return decode(rec, recsz);
+
+   RunStats::Stamp st;
+   stats->start(st);
+   int r = decode(rec, recsz);
+   stats->stop(RunStats::PARSE, st);
+   // directory entries, also with -f; what was decoded of a bad record //
+   stats->addRecord(recsz, (status == OK) ? num_entries : dir.getCount(), status);
+   return r;
+}
+
+
 void   RecordIso2709::clear( void )
 {
     status   = OK;
     buf[0]   = '\0';
     buf[1]   = '\0';
     dir.clear();
+    delims.clear();
+    tagindex.clear();
+    arena.reset();
+    rawrec   = NULL;
+    rawlen   = 0;
+    messages.clear();
 }
 
 void RecordIso2709::init( void )
@@ -215,47 +451,41 @@ void RecordIso2709::init( void )
 }
 
 
-void   RecordIso2709::print( std::ostream &outs )
+void   RecordIso2709::print( OutSink &outs )
 {
-   Field *fp;
-
    // print out record label //
-   outs << "label: " << label << '\n';
+   outs.write("label: ", 7);
+   outs.puts(label);
+   outs.put('\n');
 
    // print out each field //
-   fp = dir.getFirst();
-   while (fp)
-   {
-      fp->print(outs);
-      fp = fp->getNext();
-   }
-   outs << '\n'; // output empty line after record //
+   int n = dir.getCount();
+   for (int j = 0 ; j < n ; ++j)
+      field(j)->print(outs);
+   outs.put('\n'); // output empty line after record //
 }
 
 
-void   RecordIso2709::printXML( std::ostream &outs, int indent )
+void   RecordIso2709::printXML( OutSink &outs, int indent )
 {
-   Field *fp;
-
    // print out record label //
-   outs << "<rec>";
-   if (indent > 0) outs << '\n';
-   outs << "<lab>" << label << "</lab>";
-   if (indent > 0) outs << '\n';
+   outs.write("<rec>", 5);
+   if (indent > 0) outs.put('\n');
+   outs.write("<lab>", 5);
+   outs.writeXML(label, strlen(label));
+   outs.write("</lab>", 6);
+   if (indent > 0) outs.put('\n');
 
    // print out each field //
-   fp = dir.getFirst();
-   while (fp)
-   {
-      fp->printXML(outs,indent);
-      fp = fp->getNext();
-   }
-   outs << "</rec>\n";
+   int n = dir.getCount();
+   for (int j = 0 ; j < n ; ++j)
+      field(j)->printXML(outs,indent);
+   outs.write("</rec>\n", 7);
 }
 
 
 
-void   RecordIso2709::old_write_iso( std::ostream &outs )
+void   RecordIso2709::old_write_iso( OutSink &outs )
 {
    long   recsz , dataoffs;
    char   *formISO;
@@ -266,15 +496,13 @@ void   RecordIso2709::old_write_iso( std::ostream &outs )
    direntry_size   = 3 + Dimpl_Flen + Dimpl_Foff;
 
    recsz = 0;
-   fp   = dir.getFirst();
-   entry_count = 0;
+   entry_count = dir.getCount();
 
-   while (fp)
+   for (j = 0 ; j < entry_count ; ++j)
    {
-      ++entry_count;
+      fp = field(j);
       fp->setOffset(recsz);
       recsz += (fp->getLength() + 1);
-      fp = fp->getNext();
    }
 
    dataoffs = LABELSIZE + 1 + entry_count * direntry_size;
@@ -291,122 +519,355 @@ void   RecordIso2709::old_write_iso( std::ostream &outs )
    formISO[21] = (char)ITOC(Dimpl_Foff);
 
    bufpos = LABELSIZE;
-   fp = dir.getFirst();
-   while (fp)
+   for (j = 0 ; j < entry_count ; ++j)
    {
+      fp = field(j);
       strncpy(formISO + bufpos , fp->getTag() , 3);
       bufpos += 3;
       strutils::longtostrn( formISO + bufpos , fp->getLength()+1, Dimpl_Flen );
       bufpos += Dimpl_Flen;
       strutils::longtostrn( formISO + bufpos , fp->getOffset() , Dimpl_Foff );
       bufpos += Dimpl_Foff;
-      fp = fp->getNext();
    }
 
    formISO[bufpos++] = FT;   // terminate field //
    /*
-   fp = dir.getFirst();
-   while (fp)
+   for (j = 0 ; j < entry_count ; ++j)
    {
+      fp = field(j);
       strncpy(formISO + bufpos , fp->getData() , fp->getLength() );
       bufpos += fp->getLength();
       formISO[bufpos++] = FT;   // terminate field //
-      fp = fp->getNext();
    }
    */
    formISO[bufpos++] =  RT;   // terminate record  //
    formISO[bufpos] =  '\0';   // terminate string  //
 
-   outs << formISO;
+   outs.puts(formISO);
 
    free(formISO);
 }
 
 
-void RecordIso2709::write_iso( std::ostream &outs )
+//---------------------------------------------------------------------------------
+// write_iso(OutSink&)
+//
+// un record non modificato viene scritto cosi' come e' stato letto; gli altri
+// sono ricostruiti in un buffer riusato da un record all'altro. Restituisce 0,
+// senza scrivere nulla, se una lunghezza o un offset non sta nelle cifre
+// previste dall'etichetta
+//---------------------------------------------------------------------------------
+
+int RecordIso2709::write_iso( OutSink &outs )
 {
    long   recsz , dataoffs;
    char   *formISO;
    long   bufpos;
    long   fldoffs;
-   int   entry_count, j,i, direntry_size, formwidth = 80;
+   int   entry_count, j, direntry_size;
+   int   ok;
    Field *fp;
 
+   if (! isModified())
+   {
+      outs.write(rawrec, rawlen);
+      return 1;
+   }
+
    direntry_size = 3 + Dimpl_Flen + Dimpl_Foff;
    recsz         = 0;
 
-   entry_count = 0;
-   fp   = dir.getFirst();
-   while (fp)
-   {
-      ++entry_count;
-      recsz += fp->getLength() + 1; // + FT //
-      fp = fp->getNext();
-   }
+   entry_count = dir.getCount();
+   for (j = 0 ; j < entry_count ; ++j)
+      recsz += field(j)->getLength() + 1; // + FT //
 
    dataoffs = LABELSIZE + 1 + entry_count * direntry_size;
-   //std::cerr << "recsz: " << recsz << '\n';
-   //std::cerr << "dataoffs: " << dataoffs << '\n';
-
    recsz += dataoffs + 1;
-   formISO = new char[sizeof(char)*recsz + 2];
-   strncpy(formISO , label , LABELSIZE );
 
-   strutils::longtostrn( formISO , recsz , 5);
-   strutils::longtostrn( formISO + 12 , dataoffs , 5);
+   if ((long)isobuf.size() < recsz)
+      isobuf.resize(recsz);
+   formISO = &isobuf[0];
+   memcpy(formISO , label , LABELSIZE );
+
+   ok  = strutils::formatDecimal( formISO , recsz , 5);
+   ok &= strutils::formatDecimal( formISO + 12 , dataoffs , 5);
 
-   //formISO[10] = '0';
-   //formISO[11] = '0';
    formISO[20] = (char)ITOC(Dimpl_Flen);
    formISO[21] = (char)ITOC(Dimpl_Foff);
 
    bufpos = LABELSIZE;
 
    fldoffs = 0;
-   fp = dir.getFirst();
-   char   *dp = formISO + dataoffs + fldoffs;
-   while (fp)
+   char   *dp = formISO + dataoffs;
+   for (j = 0 ; j < entry_count ; ++j)
    {
+      fp = field(j);
       int len = fp->getLength() + 1; // fielddata + FT //
 
-  //std::cerr << "tag: " << fp->getTag() << " data: " << fp->getData() << '\n';
-      strncpy(formISO + bufpos , fp->getTag() , 3);
+      memcpy(formISO + bufpos , fp->getTag() , 3);
       bufpos += 3;
-      strutils::longtostrn( formISO + bufpos , len, Dimpl_Flen );
+      ok &= strutils::formatDecimal( formISO + bufpos , len, Dimpl_Flen );
       bufpos += Dimpl_Flen;
-      strutils::longtostrn( formISO + bufpos , fldoffs , Dimpl_Foff );
+      ok &= strutils::formatDecimal( formISO + bufpos , fldoffs , Dimpl_Foff );
       bufpos += Dimpl_Foff;
 
-  // std::cerr << "tag=" << fp->getTag() << " data=" << fp->getData() << '\n'; 
-  // std::cerr << "fldoffs: " << fldoffs  << " dataoffs: " << dataoffs << '\n';
-  // std::cerr << "offs: " << (dp - formISO) << '\n';
       memcpy(dp , fp->getData() , len-1 );
-      formISO[dataoffs+fldoffs+len-1] = FT;   // terminate field //
+      dp[len-1] = FT;   // terminate field //
 
       fldoffs += len; // recalculate next field offset //
-      fp = fp->getNext();
-      dp = formISO + dataoffs + fldoffs;
+      dp += len;
    }
-   *dp++ = RT;
-   *dp   = '\0';
+   *dp = RT;
 
-   formISO[bufpos++]    = FT;   // terminate directory //
+   formISO[bufpos++] = FT;   // terminate directory //
+
+   if (! ok)
+   {
+      report("ERROR: record too long for the directory entry map");
+      return 0;
+   }
+   outs.write(formISO, recsz);
+   return 1;
+}
 
-   outs << formISO;
 
-   delete[] formISO;
+//---------------------------------------------------------------------------------
+// isModified()
+//
+// vero se il record non corrisponde piu' ai byte letti: campi modificati o
+// scartati dal filtro, oppure record letto con lunghezza o terminatore errati
+//---------------------------------------------------------------------------------
+
+int RecordIso2709::isModified()
+{
+   if ((rawrec == NULL) || (rawlen < LABELSIZE + 1))
+      return 1;
+   if ((rawrec[rawlen-1] != RT) || (strutils::strntolong(label,5) != rawlen))
+      return 1;
+   if (dir.getCount() != num_entries)
+      return 1;
+   // a field not built yet is as read, unless -f drops some subfields //
+   int n = dir.getCount();
+   for (int j = 0 ; j < n ; ++j)
+   {
+      Field *fp = dir.get(j);
+      if ((fp == NULL) && (filter != NULL) && (filter->getCodes(dir.getEntry(j)->tag) != NULL))
+         fp = field(j);
+      if ((fp != NULL) && fp->isModified())
+         return 1;
+   }
+   return 0;
 }
 
 
 
 void   RecordIso2709::deleteControlCharacters()
 {
-   Field *fp = dir.getFirst();
-   while (fp)
+   int n = dir.getCount();
+   for (int j = 0 ; j < n ; ++j)
+     field(j)->deleteControlCharacters();
+}
+
+
+int   RecordIso2709::getFieldCount()
+{
+   return dir.getCount();
+}
+
+
+Field *   RecordIso2709::getField( int j )
+{
+   return field(j);
+}
+
+
+//---------------------------------------------------------------------------------
+// indice dei tag
+//
+// per ogni campo con tag numerico l'indice contiene (tag << 16 | posizione
+// nella directory), ordinato: i campi con un dato tag o in un intervallo di
+// tag sono un tratto contiguo trovato con una ricerca binaria.  Le directory
+// sono di norma gia' ordinate per tag, nel qual caso non serve ordinare
+//---------------------------------------------------------------------------------
+
+static int tagNumber( const char *tp )
+{
+   if (isdigit((unsigned char) tp[0]) && isdigit((unsigned char) tp[1]) &&
+       isdigit((unsigned char) tp[2]))
+      return (tp[0] - '0') * 100 + (tp[1] - '0') * 10 + (tp[2] - '0');
+   return -1;
+}
+
+
+// tag matches pattern; 'X' or 'x' in the pattern matches any character //
+static int tagMatch( const char *tp, const char *pat )
+{
+   for (int k = 0 ; k < 3 ; ++k)
+      if ((pat[k] != 'X') && (pat[k] != 'x') && (pat[k] != tp[k]))
+         return 0;
+   return 1;
+}
+
+
+void   RecordIso2709::buildTagIndex()
+{
+   int n = dir.getCount();
+   int sorted = 1;
+
+   tagindex.reserve(n);
+   for (int j = 0 ; j < n ; ++j)
+   {
+      int t = tagNumber(dir.getEntry(j)->tag);
+      if (t < 0)
+         continue;
+      int key = (t << 16) | j;
+      if (! tagindex.empty() && (key < tagindex.back()))
+         sorted = 0;
+      tagindex.push_back(key);
+   }
+   if (! sorted)
+      std::sort(tagindex.begin(), tagindex.end());
+}
+
+
+//---------------------------------------------------------------------------------
+// findFields(int, int, std::vector<Field*>&)
+//
+// aggiunge a flds i campi con tag numerico compreso tra from e to (inclusi),
+// ordinati per tag e, a parita' di tag, nell'ordine della directory;
+// restituisce il numero di campi trovati
+//---------------------------------------------------------------------------------
+
+int   RecordIso2709::findFields( int from, int to, std::vector<Field*> &flds )
+{
+   std::vector<int>::iterator i0, i1;
+   i0 = std::lower_bound(tagindex.begin(), tagindex.end(), from << 16);
+   i1 = std::lower_bound(i0, tagindex.end(), (to + 1) << 16);
+   for (std::vector<int>::iterator it = i0 ; it < i1 ; ++it)
+      flds.push_back(field(*it & 0xFFFF));
+   return i1 - i0;
+}
+
+
+//---------------------------------------------------------------------------------
+// findFields(const char*, std::vector<Field*>&)
+//
+// come sopra per un tag ("200") o un gruppo di tag ("7XX", "70X")
+//---------------------------------------------------------------------------------
+
+int   RecordIso2709::findFields( const char *tag, std::vector<Field*> &flds )
+{
+   char lo[4], hi[4];
+   int  found = 0;
+
+   for (int k = 0 ; k < 3 ; ++k)
+   {
+      int any = (tag[k] == 'X') || (tag[k] == 'x');
+      lo[k] = any ? '0' : tag[k];
+      hi[k] = any ? '9' : tag[k];
+   }
+   int from = tagNumber(lo);
+   int to   = tagNumber(hi);
+
+   if ((from < 0) || (to < 0))
+   {
+      // non numeric tag: no index //
+      int n = dir.getCount();
+      for (int j = 0 ; j < n ; ++j)
+         if (tagMatch(dir.getEntry(j)->tag, tag))
+         {
+            flds.push_back(field(j));
+            ++found;
+         }
+      return found;
+   }
+
+   if (from == to)
+      return findFields(from, to, flds);
+
+   std::vector<int>::iterator i0, i1;
+   i0 = std::lower_bound(tagindex.begin(), tagindex.end(), from << 16);
+   i1 = std::lower_bound(i0, tagindex.end(), (to + 1) << 16);
+   for (std::vector<int>::iterator it = i0 ; it < i1 ; ++it)
+   {
+      int k = *it & 0xFFFF;
+      if (tagMatch(dir.getEntry(k)->tag, tag))
+      {
+         flds.push_back(field(k));
+         ++found;
+      }
+   }
+   return found;
+}
+
+
+//---------------------------------------------------------------------------------
+// findField(const char*, int)
+//
+// n-esimo campo (da 0) con il tag dato, NULL se non presente
+//---------------------------------------------------------------------------------
+
+Field *   RecordIso2709::findField( const char *tag, int n )
+{
+   int t = tagNumber(tag);
+   if (t < 0)
    {
-     fp->deleteControlCharacters();
-     fp = fp->getNext();
+      int cnt = dir.getCount();
+      for (int j = 0 ; j < cnt ; ++j)
+         if (tagMatch(dir.getEntry(j)->tag, tag) && (n-- == 0))
+            return field(j);
+      return NULL;
    }
+
+   std::vector<int>::iterator it;
+   it = std::lower_bound(tagindex.begin(), tagindex.end(), t << 16);
+   if ((n < 0) || (n >= tagindex.end() - it) || ((it[n] >> 16) != t))
+      return NULL;
+   return field(it[n] & 0xFFFF);
+}
+
+
+//---------------------------------------------------------------------------------
+// hasTag(const char*)
+//
+// 1 se la directory del record ha un campo con il tag dato ("700", "7XX");
+// legge le voci grezze della directory, quindi vede anche i campi esclusi
+// dal filtro -f, e non costruisce i campi
+//---------------------------------------------------------------------------------
+
+int   RecordIso2709::hasTag( const char *tag )
+{
+   if (rawrec == NULL)
+      return 0;
+
+   const int esize = 3 + Dimpl_Flen + Dimpl_Foff;
+   const char *bp = rawrec + LABELSIZE;
+   for (int j = 0 ; (j < num_entries) && (bp + esize <= rawrec + rawlen) ; ++j, bp += esize)
+      if (tagMatch(bp, tag))
+         return 1;
+   return 0;
+}
+
+
+//---------------------------------------------------------------------------------
+// findSubField(const char*, char, int)
+//
+// n-esimo subfield con codice 'code' nei campi con il tag dato, es. 200 $a
+//---------------------------------------------------------------------------------
+
+SubField *   RecordIso2709::findSubField( const char *tag, char code, int n )
+{
+   Field *fp;
+   for (int k = 0 ; (fp = findField(tag, k)) != NULL ; ++k)
+   {
+      for (int j = 0 ; j < fp->getSubFieldCount() ; ++j)
+      {
+         SubField *sf = fp->getSubField(j);
+         if ((sf->getId() == code) && (n-- == 0))
+            return sf;
+      }
+   }
+   return NULL;
 }
 
 
@@ -417,9 +878,62 @@ int   RecordIso2709::getStatus()
 }
 
 
+const char *   RecordIso2709::getLabel()
+{
+   return label;
+}
+
+
+//---------------------------------------------------------------------------------
+// getMallocCount()
+//
+// numero di blocchi allocati dall'arena del record dalla sua creazione
+//---------------------------------------------------------------------------------
+
+long   RecordIso2709::getMallocCount()
+{
+   return arena.getMallocCount();
+}
+
+
+//---------------------------------------------------------------------------------
+// getAllocCount()
+//
+// numero di allocazioni (campi, sottocampi, copie) servite dall'arena del
+// record dalla sua creazione; getMallocCount() ne conta solo i blocchi
+//---------------------------------------------------------------------------------
+
+long   RecordIso2709::getAllocCount()
+{
+   return arena.getAllocCount();
+}
+
+
+//---------------------------------------------------------------------------------
+// getMessages() / report(const char*)
+//
+// errori trovati leggendo, decodificando o scrivendo il record corrente, una
+// riga ciascuno (vuoto se non ce ne sono); vengono azzerati da clear(). Il
+// record non stampa nulla: e' il chiamante a decidere dove mostrarli
+//---------------------------------------------------------------------------------
+
+const std::string &   RecordIso2709::getMessages()
+{
+   return messages;
+}
+
+
+void   RecordIso2709::report( const char *msg )
+{
+   messages += msg;
+   messages += '\n';
+}
+
+
 int   RecordIso2709::isValid()
 {
    if (status != OK)
        return 0;
+   return 1;
 }
 
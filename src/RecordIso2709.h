@@ -29,11 +29,19 @@
 #define _RECORDISO_H_
 
 #include	<iostream>
+#include	<string>
+#include	<vector>
 
 #include	"Field.h"
 #include	"FieldList.h"
+#include	"FieldFilter.h"
+#include	"Arena.h"
+#include	"RecordReader.h"
+#include	"RunStats.h"
 #include	"strutils.h"
 
+class Directory;
+
 #define LABELSIZE 24
 #define MAXRECSIZE 100352
 
@@ -60,8 +68,25 @@ class RecordIso2709
    char		fldterm;
    char		recterm;
    int		status;
-   FieldList	dir;
+   Arena	arena;		// fields and subfields of the current record //
+   FieldList	dir;		// destroyed first: its fields live in arena //
+   std::vector<char*> delims;	// positions of RT, FT and SF in the current record //
+   std::vector<int>   tagindex;	// (tag number << 16 | entry) for numeric tags, sorted //
+   std::vector<long>  seqoffs;	// field offsets assuming a sequential directory //
+   FieldFilter	*filter;	// fields to decode, NULL: all //
+   RunStats	*stats;		// --stats, NULL: not measured //
+   char		*rawrec;	// record bytes as read, valid until the next read //
+   long		rawlen;
+   std::vector<char>  isobuf;	// write_iso output, reused across records //
+   std::string	messages;	// errors found in the current record, one per line //
+   void	report( const char *msg );
+   void	buildTagIndex();
+   template <int FL, int FO> long decodeDirectory( Directory &d );
+   int	decode( char *rec, long recsz );
+   Field *field( int j );
+   Field *newField( DirEntry *e );
    std::istream *inps;
+   RecordReader *reader;	// memory mapped input, replaces inps when set //
 
  public:
    static const int OK			=  0;
@@ -70,23 +95,42 @@ class RecordIso2709
    static const int ILLEGAL_CHARACTERS	=  4;
    static const int ILLEGAL_FIELDSEP	=  8;
    static const int INVALID_RECORDLENGTH= 16;
+   static const int BAD_DIRECTORY	= 32;
 
    RecordIso2709();
    RecordIso2709( std::istream &inps );
    void init();
    void clear();
    void setInputStream( std::istream &inps );
+   void setInputReader( RecordReader &rdr );
+   int  isInputMapped();
+   long tell();
+   void setFieldFilter( FieldFilter *flt );
+   void setStats( RunStats *st );
    //int  read( std::istream &inps );
    int  read();
+   int  frame( char *&rp, long &recsz, std::vector<char*> *pos = NULL );
+   int  parse( char *rec, long recsz );
    int  getFieldCount();
-   void print( std::ostream &outs );
-   void printXML( std::ostream &outs, int indent );
-   void write_iso( std::ostream &outs );
+   Field *getField( int j );
+   Field *findField( const char *tag, int n = 0 );
+   int	hasTag( const char *tag );
+   int	findFields( const char *tag, std::vector<Field*> &flds );
+   int	findFields( int from, int to, std::vector<Field*> &flds );
+   SubField *findSubField( const char *tag, char code, int n = 0 );
+   void print( OutSink &outs );
+   void printXML( OutSink &outs, int indent );
+   int  write_iso( OutSink &outs );
+   int	isModified();
    void	deleteControlCharacters();
    int	getStatus();
+   const char *getLabel();
    int	isValid();
+   long	getMallocCount();
+   long	getAllocCount();
+   const std::string &getMessages();
 
-   void old_write_iso( std::ostream &outs );
+   void old_write_iso( OutSink &outs );
 };
 
 
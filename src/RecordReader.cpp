@@ -0,0 +1,425 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cctype>
+#include	<cstring>
+#include	<climits>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+
+#include "RecordIso2709.h"
+#include "RecordReader.h"
+#include "Decompressor.h"
+#include "scanutils.h"
+
+
+RecordReader::RecordReader()
+{
+   base    = NULL;
+   size    = 0;
+   mtime   = 0;
+   pos     = 0;
+   limit   = 0;
+   recoffs = 0;
+   fd      = -1;
+   zin     = NULL;
+   winoffs = 0;
+   zeof    = 0;
+   error   = NULL;
+}
+
+
+RecordReader::~RecordReader()
+{
+   close();
+}
+
+
+//---------------------------------------------------------------------------------
+// open(const char*)
+//
+// mappa in memoria un file regolare. Un file compresso (riconosciuto dai
+// primi byte) non viene mappato ma decompresso da un thread, e cosi' un file
+// che non puo' essere mappato (pipe, device, ...) viene letto da un thread.
+// Restituisce 0 se il file non puo' essere aperto o se il formato compresso
+// non e' supportato (getError() ne da' il motivo)
+//---------------------------------------------------------------------------------
+
+int RecordReader::open(const char *fname)
+{
+   struct stat st;
+   unsigned char magic[4];
+
+   close();
+   error = NULL;
+   fd = ::open(fname, O_RDONLY);
+   if (fd < 0)
+      return 0;
+
+   if (fstat(fd, &st) != 0)
+   {
+      close();
+      return 0;
+   }
+   if (! S_ISREG(st.st_mode))
+      return startThread(Decompressor::AUTO);
+   mtime = (long long) st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+
+   int format = Decompressor::detect(magic, pread(fd, magic, sizeof(magic), 0));
+   if (format != Decompressor::NONE)
+   {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      return startThread(format);
+   }
+
+   size  = st.st_size;
+   pos   = 0;
+   limit = size;
+   if (size == 0)
+      return 1;   // empty file: nothing to map, no records //
+
+   void *mp = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if (mp == MAP_FAILED)
+      return startThread(Decompressor::NONE);
+   base = (char*) mp;
+
+   // records are consumed strictly in file order //
+   madvise(base, size, MADV_SEQUENTIAL);
+   posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+   return 1;
+}
+
+
+//---------------------------------------------------------------------------------
+// openStream(int)
+//
+// legge i record da un file descriptor gia' aperto (standard input, pipe)
+// tramite il thread di read-ahead; l'input puo' essere compresso
+//---------------------------------------------------------------------------------
+
+int RecordReader::openStream( int ifd )
+{
+   close();
+   error = NULL;
+   fd = dup(ifd);
+   if (fd < 0)
+      return 0;
+   return startThread(Decompressor::AUTO);
+}
+
+
+// read fd (compressed or not) on a Decompressor thread instead of mapping it //
+int RecordReader::startThread( int format )
+{
+   size  = pos = 0;
+   limit = LONG_MAX;
+   zin   = new Decompressor();
+   if (! zin->open(fd, format))
+   {
+      close();
+      error = "compressed input-file format not supported by this build";
+      return 0;
+   }
+   return 1;
+}
+
+
+void RecordReader::close()
+{
+   if (zin != NULL)
+      delete zin;   // stops the read-ahead thread //
+   if (base != NULL)
+      munmap(base, size);
+   if (fd >= 0)
+      ::close(fd);
+   base = NULL;
+   size = pos = limit = recoffs = 0;
+   mtime = 0;
+   fd   = -1;
+   zin  = NULL;
+   win.clear();
+   winoffs = 0;
+   zeof    = 0;
+}
+
+
+int RecordReader::isOpen()
+{
+   return (fd >= 0);
+}
+
+
+int RecordReader::isMapped()
+{
+   return (fd >= 0) && (zin == NULL);
+}
+
+
+//---------------------------------------------------------------------------------
+// next(char*&, long&, std::vector<char*>*)
+//
+// restituisce in rp/len il prossimo record (etichetta ... RT compreso);
+// come nella lettura da stream gli spazi bianchi tra i record vengono saltati
+// e un record non terminato a fine file viene restituito cosi' com'e'.
+// Se delims non e' NULL vi aggiunge le posizioni di RT, FT e SF del record,
+// trovate nella stessa passata che cerca la fine del record
+//---------------------------------------------------------------------------------
+
+int RecordReader::next(char *&rp, long &len, std::vector<char*> *delims)
+{
+   char *ep;
+
+   if (zin != NULL)
+      return nextCompressed(rp, len, delims);
+   if (pos >= limit)
+      return 0;   // next record belongs to the following shard //
+   while ((pos < size) && isspace(base[pos]))
+      ++pos;
+   if (pos >= size)
+      return 0;
+
+   recoffs = pos;
+   rp = base + pos;
+   if (delims != NULL)
+      len = scanutils::scanDelimiters(rp, size - pos, *delims);
+   else
+   {
+      ep  = scanutils::findByte(rp, size - pos, RT);
+      len = (ep != NULL) ? (ep - rp + 1) : (size - pos);
+   }
+   pos += len;
+   return 1;
+}
+
+
+//---------------------------------------------------------------------------------
+// nextCompressed(char*&, long&, std::vector<char*>*)
+//
+// come next(), ma su input decompresso: il record viene cercato nella
+// finestra win, che viene riempita dal decompressore finche' non contiene
+// un RT (o l'input e' finito). Il record resta valido fino al next() seguente
+//---------------------------------------------------------------------------------
+
+int RecordReader::nextCompressed(char *&rp, long &len, std::vector<char*> *delims)
+{
+   char *ep = NULL;
+   long scanned = 0;   // bytes after pos already searched for RT //
+
+   for (;;)
+   {
+      while ((pos < size) && isspace(win[pos]))
+         ++pos;
+      if (pos < size)
+      {
+         ep = scanutils::findByte(&win[0] + pos + scanned, size - pos - scanned, RT);
+         if (ep != NULL)
+            break;
+         scanned = size - pos;
+      }
+      if (! fill())
+         break;
+   }
+   if (pos >= size)
+      return 0;
+
+   recoffs = winoffs + pos;
+   rp  = &win[0] + pos;
+   len = (ep != NULL) ? (ep - rp + 1) : (size - pos);
+   if (delims != NULL)
+      scanutils::scanDelimiters(rp, len, *delims);
+   pos += len;
+   return 1;
+}
+
+
+// drop the bytes before pos and append decompressed data to win; 0 at end //
+int RecordReader::fill()
+{
+   const long chunk = 1024 * 1024;
+
+   if (zeof)
+      return 0;
+   if (pos > 0)
+   {
+      memmove(&win[0], &win[0] + pos, size - pos);
+      winoffs += pos;
+      size    -= pos;
+      pos      = 0;
+   }
+   if ((long) win.size() < size + chunk)
+      win.resize(size + chunk);
+   long n = zin->read(&win[0] + size, chunk);
+   if (n == 0)
+   {
+      zeof = 1;
+      return 0;
+   }
+   size += n;
+   return 1;
+}
+
+
+long RecordReader::tell()
+{
+   return recoffs;
+}
+
+
+//---------------------------------------------------------------------------------
+// seek(long)
+//
+// il prossimo next() restituisce il record che inizia all'offset offs
+// (accesso diretto tramite indice); da qui in poi la lettura non e' piu'
+// sequenziale. Restituisce 0 se offs e' fuori dal file
+//---------------------------------------------------------------------------------
+
+int RecordReader::seek( long offs )
+{
+   if ((zin != NULL) || (offs < 0) || (offs > size))
+      return 0;
+   if ((base != NULL) && (pos == 0))
+      madvise(base, size, MADV_RANDOM);
+   pos = offs;
+   return 1;
+}
+
+
+// plausible record label at p: 5 digit record length of at least a label,
+// the record ending with RT within the file, 5 digit base address [12-16] //
+static int isLabelAt( const char *p, const char *end )
+{
+   long len = 0;
+
+   if (end - p < LABELSIZE)
+      return 0;
+   for (int j = 0 ; j < 5 ; ++j)
+   {
+      if (! isdigit((unsigned char) p[j]) || ! isdigit((unsigned char) p[12 + j]))
+         return 0;
+      len = len * 10 + (p[j] - '0');
+   }
+   return (len >= LABELSIZE) && (len <= end - p) && (p[len - 1] == RT);
+}
+
+
+//---------------------------------------------------------------------------------
+// resync(long)
+//
+// primo inizio di record a partire da offs: il byte dopo un RT (cercato dal
+// byte precedente offs), se dopo gli spazi bianchi vi comincia un'etichetta
+// plausibile; un RT isolato nei dati viene cosi' saltato. size se non ce ne sono
+//---------------------------------------------------------------------------------
+
+long RecordReader::resync( long offs )
+{
+   char *end = base + size;
+   char *p   = base + offs - 1;
+   char *ep;
+
+   if (offs <= 0)
+      return 0;
+   while ((p < end) && ((ep = scanutils::findByte(p, end - p, RT)) != NULL))
+   {
+      char *q = ep + 1;
+      while ((q < end) && isspace(*q))
+         ++q;
+      if (isLabelAt(q, end))
+         return ep + 1 - base;
+      p = ep + 1;
+   }
+   return size;
+}
+
+
+//---------------------------------------------------------------------------------
+// setShard(int, int)
+//
+// limita la lettura alla parte shard (0 .. nshards-1) del file: il file e'
+// diviso in nshards intervalli di byte e ogni parte legge i record che
+// cominciano nel proprio intervallo. Gli estremi degli intervalli vengono
+// riallineati con resync() all'inizio di un record (come in next(), che
+// chiude il record al primo RT); la fine di una parte e l'inizio della
+// seguente sono calcolati allo stesso modo, cosi' parti contigue si dividono
+// i record senza buchi ne' sovrapposizioni
+//---------------------------------------------------------------------------------
+
+void RecordReader::setShard( int shard, int nshards )
+{
+   long lo = (size / nshards) * shard;
+   long hi = (shard + 1 < nshards) ? (size / nshards) * (shard + 1) : size;
+
+   if (zin != NULL)
+      return;
+   pos   = resync(lo);
+   limit = (hi < size) ? resync(hi) : size;
+}
+
+
+long RecordReader::getSize()
+{
+   return size;
+}
+
+
+long long RecordReader::getModTime()
+{
+   return mtime;
+}
+
+
+//---------------------------------------------------------------------------------
+// finish()
+//
+// da chiamare a fine lettura, prima di getError(): un input letto dal thread
+// (compresso, pipe) viene letto fino in fondo scartando quello che resta,
+// cosi' un errore di decompressione dopo l'ultimo record letto non va perso
+//---------------------------------------------------------------------------------
+
+const char *RecordReader::finish()
+{
+   if (zin != NULL)
+      while (fill())
+         pos = size;   // drop the data, keep the window small //
+   return getError();
+}
+
+
+//---------------------------------------------------------------------------------
+// getError()
+//
+// motivo per cui il file non e' stato aperto o la decompressione si e'
+// interrotta; NULL se non ci sono errori
+//---------------------------------------------------------------------------------
+
+const char *RecordReader::getError()
+{
+   if ((error == NULL) && (zin != NULL))
+      return zin->getError();
+   return error;
+}
@@ -0,0 +1,84 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _RECORDREADER_H_
+#define _RECORDREADER_H_
+
+#include	<vector>
+
+class Decompressor;
+
+
+/*
+ * RecordReader: zero-copy input for regular files.
+ * The whole input file is mapped read-only into memory and each call to
+ * next() returns a view (pointer + length) of the next record inside the
+ * mapping; no data is copied.  Views stay valid until close().
+ * Compressed files (gzip, zstd), pipes and standard input are not mapped:
+ * a read-ahead thread (Decompressor) fills a window buffer, and a view
+ * stays valid only until the following next(); seek() and setShard()
+ * need a mapped file.
+ */
+class RecordReader
+{
+  public:
+	RecordReader();
+	~RecordReader();
+	int	open(const char *fname);
+	int	openStream( int ifd );
+	void	close();
+	int	isOpen();
+	int	isMapped();
+	int	next(char *&rp, long &len, std::vector<char*> *delims = NULL);
+	long	tell();
+	int	seek( long offs );
+	void	setShard( int shard, int nshards );
+	long	getSize();
+	long long getModTime();
+	const char *finish();
+	const char *getError();
+
+  private:
+	char	*base;		// start of mapping //
+	long	size;		// size of mapped file //
+	long long mtime;	// modification time of the file in ns, 0: not a regular file //
+	long	pos;		// current read position //
+	long	limit;		// next() stops at a record starting here //
+	long	recoffs;	// offset of last record returned by next() //
+	int	fd;
+	Decompressor	*zin;	// read-ahead thread, NULL: mapped //
+	std::vector<char> win;	// decompressed window, holds the current record //
+	long	winoffs;	// input offset of win[0] //
+	int	zeof;		// decompressor drained //
+	const char *error;
+	int	nextCompressed( char *&rp, long &len, std::vector<char*> *delims );
+	int	fill();
+	int	startThread( int format );
+	long	resync( long offs );
+};
+
+#endif /* _RECORDREADER_H_ */
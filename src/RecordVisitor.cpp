@@ -0,0 +1,200 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstdlib>
+#include	<cstring>
+
+#include "RecordVisitor.h"
+#include "RecordIso2709.h"
+#include "Directory.h"
+#include "strutils.h"
+#include "scanutils.h"
+
+
+RecordVisitor::~RecordVisitor()
+{
+}
+
+
+//---------------------------------------------------------------------------------
+// visit(const char*, long)
+//
+// controlla etichetta, directory e separatori di campo del record lungo
+// recsz byte che inizia in rec, come RecordIso2709::parse(); se e' valido
+// ne segnala i campi con i metodi del visitor. Restituisce lo stato del
+// record (RecordIso2709::OK oppure i bit di errore)
+//---------------------------------------------------------------------------------
+
+int RecordVisitor::visit( const char *rec, long recsz )
+{
+   Directory d;
+   char  label[LABELSIZE + 1];
+   char  tag[4];
+   const char *fdp;
+   long  len, offs, seqoffs;
+   int   status = RecordIso2709::OK;
+
+   if (! d.decode(rec, recsz, label, status))
+      return status;
+
+   // every entry is decoded and every field found before the first event //
+   long nentries = d.getCount();
+   int  esize    = d.getEntrySize();
+   int  found    = 1;
+   seqoffs = 0;
+   for (long j = 0 ; j < nentries ; ++j)
+   {
+      if (d.entry<0,0>(d.getEntries() + j * esize, len, offs))
+         status |= RecordIso2709::BAD_DIRECTORY;
+      if (found && (d.locate(len, offs, seqoffs) == NULL))
+      {
+         status |= RecordIso2709::ILLEGAL_FIELDSEP;
+         found = 0;
+      }
+      seqoffs += len + 1;
+   }
+   if (status != RecordIso2709::OK)
+      return status;
+
+   if (! startRecord(label))
+      return status;
+   seqoffs = 0;
+   tag[3]  = '\0';
+   for (long j = 0 ; j < nentries ; ++j)
+   {
+      const char *entry = d.getEntries() + j * esize;
+      d.entry<0,0>(entry, len, offs);
+      fdp = d.locate(len, offs, seqoffs);
+      seqoffs += len + 1;
+      memcpy(tag, entry, 3);
+      if ((tag[0] == '0') && (tag[1] == '0'))
+         controlField(tag, fdp, len);
+      else
+         dataField(tag, fdp, len);
+   }
+   endRecord();
+   return status;
+}
+
+
+//---------------------------------------------------------------------------------
+// dataField(const char*, const char*, long)
+//
+// indicatori e subfield di un campo dati; dopo un $1 i subfield fino al
+// $1 seguente appartengono al campo incorporato (come in Field::printXML)
+//---------------------------------------------------------------------------------
+
+void RecordVisitor::dataField( const char *tag, const char *dp, long len )
+{
+   const char *p1  = dp + 2;
+   const char *end = dp + len;
+   int  ins1 = 0;		// inside an embedded field //
+   int  indf = 0;		// inside an embedded data field //
+   int  skip = 0;		// subfields of a skipped embedded data field //
+
+   if (! startDataField(tag, (len > 0) ? dp[0] : ' ', (len > 1) ? dp[1] : ' '))
+      return;
+
+   if ((p1 < end) && (*p1 == SF))
+      ++p1;
+   while (p1 < end)
+   {
+      const char *p2 = scanutils::findByte((char*) p1, end - p1, SF);
+      if (p2 == NULL)
+         p2 = end;
+      long l = p2 - p1;
+      if ((l > 0) && (*p1 == '1'))
+      {
+         const char *data = p1 + 1;
+         long dl = l - 1;
+         char etag[4];
+
+         if (ins1)
+         {
+            if (indf)
+               endDataField();
+            endEmbeddedField();
+         }
+         startEmbeddedField();
+         ins1 = 1;
+         indf = skip = 0;
+         memcpy(etag, data, (dl < 3) ? dl : 3);
+         etag[(dl < 3) ? dl : 3] = '\0';
+         if ((dl >= 2) && (data[0] == '0') && (data[1] == '0'))
+            controlField(etag, data + 3, (dl > 3) ? dl - 3 : 0);
+         else
+         {
+            indf = startDataField(etag, (dl > 3) ? data[3] : ' ', (dl > 4) ? data[4] : ' ');
+            skip = ! indf;
+         }
+      }
+      else
+      if (! skip)
+         subField(*p1, p1 + 1, (l > 0) ? l - 1 : 0);   // code SF: empty, between two SF //
+      p1 = p2 + 1;
+   }
+   if (indf)
+      endDataField();
+   if (ins1)
+      endEmbeddedField();
+   endDataField();
+}
+
+
+int RecordVisitor::startRecord( const char * )
+{
+   return 1;
+}
+
+void RecordVisitor::endRecord()
+{
+}
+
+void RecordVisitor::controlField( const char *, const char *, int )
+{
+}
+
+int RecordVisitor::startDataField( const char *, char, char )
+{
+   return 1;
+}
+
+void RecordVisitor::endDataField()
+{
+}
+
+void RecordVisitor::subField( char, const char *, int )
+{
+}
+
+void RecordVisitor::startEmbeddedField()
+{
+}
+
+void RecordVisitor::endEmbeddedField()
+{
+}
@@ -0,0 +1,71 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _RECORDVISITOR_H_
+#define _RECORDVISITOR_H_
+
+
+/*
+ * RecordVisitor: event driven (SAX-like) reading of an ISO 2709 record.
+ * visit() walks label, directory and fields straight off the record
+ * buffer, e.g. a view returned by RecordReader::next(), and calls the
+ * methods below; no Field or SubField is built and nothing is allocated.
+ * Subclasses override only the events they need, the defaults do nothing.
+ * Tags and the label are '\0' terminated copies, field and subfield data
+ * point into the record (len bytes, not terminated) and are valid only
+ * during the call.
+ * A UNIMARC embedded field (subfield $1, as in the 4XX link fields) is
+ * reported between startEmbeddedField() and endEmbeddedField() as a
+ * control field, or as a data field followed by the subfields up to the
+ * next $1, as in the <s1> element of the XML output.
+ * visit() first checks the whole record: a record that RecordIso2709
+ * would reject fires no event, and its status bits are returned.
+ * A visitor keeps no other state than its own, so one instance per
+ * thread can visit records in parallel.
+ */
+class RecordVisitor
+{
+  public:
+	virtual ~RecordVisitor();
+	int	visit( const char *rec, long recsz );
+
+	// return 0 to skip the fields of the record (and endRecord) //
+	virtual int	startRecord( const char *label );
+	virtual void	endRecord();
+	virtual void	controlField( const char *tag, const char *data, int len );
+	// return 0 to skip the subfields of the field (and endDataField) //
+	virtual int	startDataField( const char *tag, char ind1, char ind2 );
+	virtual void	endDataField();
+	virtual void	subField( char code, const char *data, int len );
+	virtual void	startEmbeddedField();
+	virtual void	endEmbeddedField();
+
+  private:
+	void	dataField( const char *tag, const char *dp, long len );
+};
+
+#endif /* _RECORDVISITOR_H_ */
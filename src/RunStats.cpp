@@ -0,0 +1,297 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include	<cstdio>
+#include	<ctime>
+#include	<sys/time.h>
+#include	<sys/resource.h>
+
+#include "RunStats.h"
+
+
+static const char *const phasenames[RunStats::NPHASES] = { "read", "parse", "serialize", "write" };
+
+// same order as the RecordIso2709 status bits //
+static const char *const statusnames[RunStats::NSTATUS] =
+{
+   "BAD_LABEL", "BAD_DATA", "ILLEGAL_CHARACTERS", "ILLEGAL_FIELDSEP", "INVALID_RECORDLENGTH",
+   "BAD_DIRECTORY"
+};
+
+
+// Nanoseconds of the given clock.
+static long nanos( clockid_t clk )
+{
+   struct timespec ts;
+   clock_gettime(clk, &ts);
+   return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// Seconds of a timeval.
+static double seconds( const struct timeval &tv )
+{
+   return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+RunStats::RunStats()
+{
+   for (int j = 0 ; j < NPHASES ; ++j)
+      wall[j] = cpu[j] = 0;
+   for (int j = 0 ; j < NBUCKETS ; ++j)
+      sizes[j] = fields[j] = 0;
+   for (int j = 0 ; j < NSTATUS ; ++j)
+      statusbits[j] = 0;
+   started  = nanos(CLOCK_MONOTONIC);
+   records  = 0;
+   bytesin  = 0;
+   bytesout = 0;
+   mallocs  = 0;
+   allocs   = 0;
+   badstatus = 0;
+   total = good = bad = 0;
+}
+
+
+void RunStats::start( Stamp &st )
+{
+   st.wall  = nanos(CLOCK_MONOTONIC);
+   st.cpu   = nanos(CLOCK_THREAD_CPUTIME_ID);
+   st.wwall = wall[WRITE];
+   st.wcpu  = cpu[WRITE];
+}
+
+
+//---------------------------------------------------------------------------------
+// stop(int, const Stamp&)
+//
+// aggiunge alla fase il tempo trascorso da start(), tolto quello che nel
+// frattempo e' stato contato come scrittura
+//---------------------------------------------------------------------------------
+
+void RunStats::stop( int phase, const Stamp &st )
+{
+   long w = nanos(CLOCK_MONOTONIC) - st.wall;
+   long c = nanos(CLOCK_THREAD_CPUTIME_ID) - st.cpu;
+
+   if (phase != WRITE)
+   {
+      w -= wall[WRITE] - st.wwall;
+      c -= cpu[WRITE] - st.wcpu;
+   }
+   wall[phase] += w;
+   cpu[phase]  += c;
+}
+
+
+//---------------------------------------------------------------------------------
+// addRecord(long, int, int)
+//
+// conta un record decodificato: lunghezza, numero di campi nella directory
+// e, per un record non valido, i bit di stato
+//---------------------------------------------------------------------------------
+
+void RunStats::addRecord( long size, int nfields, int status )
+{
+   ++records;
+   bytesin += size;
+   ++sizes[bucket(size)];
+   ++fields[bucket(nfields)];
+   if (status != 0)
+   {
+      ++badstatus;
+      for (int j = 0 ; j < NSTATUS ; ++j)
+         if (status & (1 << j))
+            ++statusbits[j];
+   }
+}
+
+
+void RunStats::addOutput( long nbytes )
+{
+   bytesout += nbytes;
+}
+
+
+void RunStats::addMallocs( long blocks, long nallocs )
+{
+   mallocs += blocks;
+   allocs  += nallocs;
+}
+
+
+//---------------------------------------------------------------------------------
+// merge(const RunStats&)
+//
+// somma i contatori di un altro thread (pipeline -j) a questi
+//---------------------------------------------------------------------------------
+
+void RunStats::merge( const RunStats &rs )
+{
+   for (int j = 0 ; j < NPHASES ; ++j)
+   {
+      wall[j] += rs.wall[j];
+      cpu[j]  += rs.cpu[j];
+   }
+   for (int j = 0 ; j < NBUCKETS ; ++j)
+   {
+      sizes[j]  += rs.sizes[j];
+      fields[j] += rs.fields[j];
+   }
+   for (int j = 0 ; j < NSTATUS ; ++j)
+      statusbits[j] += rs.statusbits[j];
+   records   += rs.records;
+   bytesin   += rs.bytesin;
+   bytesout  += rs.bytesout;
+   mallocs   += rs.mallocs;
+   allocs    += rs.allocs;
+   badstatus += rs.badstatus;
+}
+
+
+void RunStats::setCounts( long t, long g, long b )
+{
+   total = t;
+   good  = g;
+   bad   = b;
+}
+
+
+// Histogram bucket of v: [2^b, 2^(b+1)), 0 and 1 in the first one.
+long RunStats::bucket( long v )
+{
+   long b = 0;
+   while ((v > 1) && (b < NBUCKETS - 1))
+   {
+      v >>= 1;
+      ++b;
+   }
+   return b;
+}
+
+
+//---------------------------------------------------------------------------------
+// print(FILE*)
+//
+// riepilogo leggibile della conversione
+//---------------------------------------------------------------------------------
+
+void RunStats::print( FILE *fp )
+{
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+   double elapsed = (nanos(CLOCK_MONOTONIC) - started) / 1e9;
+   double rate    = (elapsed > 0) ? 1.0 / elapsed : 0;
+
+   fprintf(fp, "statistics:\n");
+   fprintf(fp, "  records    %12ld   good %ld   bad %ld\n", total, good, bad);
+   fprintf(fp, "  wall       %12.3f s   %.0f records/s\n", elapsed, total * rate);
+   fprintf(fp, "  cpu        %12.3f s   user %.3f s   sys %.3f s\n",
+           seconds(ru.ru_utime) + seconds(ru.ru_stime), seconds(ru.ru_utime), seconds(ru.ru_stime));
+   fprintf(fp, "  bytes in   %12ld     %.1f MB/s\n", bytesin, bytesin * rate / 1e6);
+   fprintf(fp, "  bytes out  %12ld     %.1f MB/s (before compression)\n", bytesout, bytesout * rate / 1e6);
+   fprintf(fp, "  arena      %12ld allocations   %.1f per record   %ld blocks\n",
+           allocs, (records > 0) ? (double) allocs / records : 0.0, mallocs);
+   fprintf(fp, "  phase          wall s      cpu s   (summed over threads)\n");
+   for (int j = 0 ; j < NPHASES ; ++j)
+      fprintf(fp, "  %-10s %10.3f %10.3f\n", phasenames[j], wall[j] / 1e9, cpu[j] / 1e9);
+   printHistogram(fp, "record length (bytes)", sizes);
+   printHistogram(fp, "fields per record", fields);
+   if (bad > 0)
+   {
+      fprintf(fp, "  bad records by status bit:\n");
+      for (int j = 0 ; j < NSTATUS ; ++j)
+         if (statusbits[j] > 0)
+            fprintf(fp, "    %-22s %10ld\n", statusnames[j], statusbits[j]);
+      if (bad > badstatus)
+         fprintf(fp, "    %-22s %10ld\n", "ISO output failed", bad - badstatus);
+   }
+}
+
+
+void RunStats::printHistogram( FILE *fp, const char *title, const long *hist )
+{
+   fprintf(fp, "  %s:\n", title);
+   for (int j = 0 ; j < NBUCKETS ; ++j)
+      if (hist[j] > 0)
+      {
+         if (j == NBUCKETS - 1)
+            fprintf(fp, "    %7ld -        %10ld\n", 1L << j, hist[j]);
+         else
+            fprintf(fp, "    %7ld - %7ld %10ld\n", (j == 0) ? 0L : 1L << j, (2L << j) - 1, hist[j]);
+      }
+}
+
+
+//---------------------------------------------------------------------------------
+// printJSON(FILE*)
+//
+// lo stesso riepilogo come oggetto JSON, su una riga
+//---------------------------------------------------------------------------------
+
+void RunStats::printJSON( FILE *fp )
+{
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+   double elapsed = (nanos(CLOCK_MONOTONIC) - started) / 1e9;
+
+   fprintf(fp, "{\"records\":%ld,\"good\":%ld,\"bad\":%ld", total, good, bad);
+   fprintf(fp, ",\"wall_s\":%.6f,\"cpu_user_s\":%.6f,\"cpu_sys_s\":%.6f",
+           elapsed, seconds(ru.ru_utime), seconds(ru.ru_stime));
+   fprintf(fp, ",\"records_per_s\":%.1f", (elapsed > 0) ? total / elapsed : 0);
+   fprintf(fp, ",\"bytes_in\":%ld,\"bytes_out\":%ld", bytesin, bytesout);
+   fprintf(fp, ",\"arena_allocations\":%ld,\"arena_blocks\":%ld", allocs, mallocs);
+   fprintf(fp, ",\"phases\":{");
+   for (int j = 0 ; j < NPHASES ; ++j)
+      fprintf(fp, "%s\"%s\":{\"wall_s\":%.6f,\"cpu_s\":%.6f}", (j > 0) ? "," : "",
+              phasenames[j], wall[j] / 1e9, cpu[j] / 1e9);
+   fprintf(fp, "}");
+   printHistogramJSON(fp, "record_length", sizes);
+   printHistogramJSON(fp, "fields_per_record", fields);
+   fprintf(fp, ",\"bad_by_status\":{");
+   for (int j = 0 ; j < NSTATUS ; ++j)
+      fprintf(fp, "%s\"%s\":%ld", (j > 0) ? "," : "", statusnames[j], statusbits[j]);
+   fprintf(fp, ",\"ISO_OUTPUT\":%ld}}\n", (bad > badstatus) ? bad - badstatus : 0L);
+}
+
+
+void RunStats::printHistogramJSON( FILE *fp, const char *name, const long *hist )
+{
+   int first = 1;
+
+   fprintf(fp, ",\"%s\":[", name);
+   for (int j = 0 ; j < NBUCKETS ; ++j)
+      if (hist[j] > 0)
+      {
+         fprintf(fp, "%s{\"min\":%ld,", first ? "" : ",", (j == 0) ? 0L : 1L << j);
+         if (j < NBUCKETS - 1)
+            fprintf(fp, "\"max\":%ld,", (2L << j) - 1);
+         fprintf(fp, "\"count\":%ld}", hist[j]);
+         first = 0;
+      }
+   fprintf(fp, "]");
+}
@@ -0,0 +1,98 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _RUNSTATS_H_
+#define _RUNSTATS_H_
+
+#include	<cstdio>
+
+
+/*
+ * RunStats: counters and timings of a conversion run (--stats).
+ * The phases are read (framing the records of the input), parse
+ * (decoding label, directory and fields), serialize (text, XML or ISO
+ * output into the sinks) and write (flushing the sinks to the files,
+ * compression included).  Times are taken with start()/stop(); the write
+ * time spent inside another phase, e.g. a sink flushed while a record is
+ * serialized, is counted only once, as write.  With -j each thread keeps
+ * its own RunStats, merged at the end, so phase times are summed over
+ * the threads.  Nothing is measured when no RunStats is given, which is
+ * the default: the hot paths only test a NULL pointer.
+ */
+class RunStats
+{
+  public:
+	static const int READ		= 0;
+	static const int PARSE		= 1;
+	static const int SERIALIZE	= 2;
+	static const int WRITE		= 3;
+	static const int NPHASES	= 4;
+	static const int NBUCKETS	= 18;	// powers of two, up to 128K //
+	static const int NSTATUS	= 6;	// RecordIso2709 status bits //
+
+	struct Stamp
+	{
+		long	wall;
+		long	cpu;
+		long	wwall;		// write time at start() //
+		long	wcpu;
+	};
+
+	RunStats();
+	void	start( Stamp &st );
+	void	stop( int phase, const Stamp &st );
+	void	addRecord( long size, int nfields, int status );
+	void	addOutput( long nbytes );
+	void	addMallocs( long blocks, long allocs );
+	void	merge( const RunStats &rs );
+	void	setCounts( long total, long good, long bad );
+	void	print( FILE *fp );
+	void	printJSON( FILE *fp );
+
+  private:
+	static long	bucket( long v );
+	void	printHistogram( FILE *fp, const char *title, const long *hist );
+	void	printHistogramJSON( FILE *fp, const char *name, const long *hist );
+
+	long	wall[NPHASES];		// nanoseconds //
+	long	cpu[NPHASES];		// thread CPU time, nanoseconds //
+	long	started;		// wall clock at construction //
+	long	records;		// records framed and parsed //
+	long	bytesin;
+	long	bytesout;		// before compression //
+	long	mallocs;		// arena blocks //
+	long	allocs;		// arena allocations //
+	long	sizes[NBUCKETS];	// record length histogram //
+	long	fields[NBUCKETS];	// directory entries histogram //
+	long	statusbits[NSTATUS];	// bad records with each status bit //
+	long	badstatus;		// records with status != OK //
+	long	total;
+	long	good;
+	long	bad;
+};
+
+#endif /* _RUNSTATS_H_ */
@@ -30,32 +30,42 @@
 #include <cstring>
 
 #include "Field.h"
+#include "Arena.h"
 #include "strutils.h"
 
 
 SubField::SubField()
 {
-   id   = 255;
-   data = NULL;
+   id    = 255;
+   data  = NULL;
+   len   = 0;
+   owned = 0;
+   arena = NULL;
 }
 
 
 SubField::SubField(char ident, char *dp, int len)
 {
-   id = ident;
+   id    = ident;
+   data  = NULL;
+   owned = 0;
+   arena = NULL;
    setData(dp,len);
 }
 
 
 SubField::SubField(char *dp, int len)
 {
+   data  = NULL;
+   owned = 0;
+   arena = NULL;
    setRawData(dp,len);
 }
 
 
 SubField::~SubField()
 {
-   if (data != NULL)
+   if (owned && (arena == NULL))
    {
       delete[] data;
       data = NULL;
@@ -63,6 +73,50 @@ SubField::~SubField()
 }
 
 
+//---------------------------------------------------------------------------------
+// init(Arena*, char*, int)
+//
+// come setRawData(char*, int) per un subfield appena creato; se i dati
+// vengono modificati la copia e' allocata nell'arena del record
+//---------------------------------------------------------------------------------
+
+void SubField::init(Arena *ar, char *dp, int len)
+{
+   arena = ar;
+   setRawData(dp,len);
+}
+
+
+char * SubField::allocData(int len)
+{
+   if (arena != NULL)
+      return (char*) arena->alloc(len);
+   return new char[len];
+}
+
+
+//---------------------------------------------------------------------------------
+// materialize(int)
+//
+// sostituisce la vista sul record con una copia propria di almeno sz byte,
+// terminata da '\0'; la vecchia copia (se allocata con new[]) viene liberata
+//---------------------------------------------------------------------------------
+
+void SubField::materialize(int sz)
+{
+   char *dtmp = data;
+   int   otmp = owned;
+
+   data = allocData(sz+1);
+   if (dtmp != NULL)
+      memcpy(data, dtmp, (len < sz) ? len : sz);
+   data[sz] = '\0';
+   owned = 1;
+   if (otmp && (arena == NULL))
+      delete[] dtmp;
+}
+
+
 char SubField::getId()
 {
    return id;
@@ -75,6 +129,14 @@ void SubField::setId( char sfid )
 }
 
 
+//---------------------------------------------------------------------------------
+// getData()/getRawData()
+//
+// dati del subfield senza e con il codice in prima posizione; se il subfield
+// non e' stato modificato sono una vista sul record, non terminata da '\0':
+// usare getLength() (codice compreso) per la lunghezza
+//---------------------------------------------------------------------------------
+
 char * SubField::getData()
 {
    return data + 1;
@@ -87,96 +149,95 @@ char * SubField::getRawData()
 }
 
 
+int SubField::isModified()
+{
+   return owned;
+}
+
 
 void SubField::setRawData(char *dp)
 {
   if (dp == NULL)
      return;
-  id = dp[0];
-
-  int len = strlen(dp);
-  data = new char[len+1];
-  if (len > 0)
-     memcpy(data, dp, len);
-  data[len]='\0';
+  setRawData(dp, strlen(dp));
 }
 
 
-void SubField::setRawData(char *dp, int len)
+void SubField::setRawData(char *dp, int l)
 {
   if (dp == NULL)
     return;
-  if (len < 0)
+  if (l < 0)
      return;
-  id = dp[0];
-  data = new char[len+1];
-  if (len > 0)
-     memcpy(data, dp, len);
-  data[len]='\0';
+  if (owned && (arena == NULL))
+     delete[] data;
+  id    = dp[0];
+  data  = dp;   // view, no copy //
+  len   = l;
+  owned = 0;
 }
 
 
-void SubField::setData(char *dp, int len)
+void SubField::setData(char *dp, int l)
 {
-  char *dtmp;
   if (dp == NULL)
     return;
-  if (len < 0)
+  if (l < 0)
      return;
 
-  dtmp = data; // save pointer to data //
-  data = new char[len+2];   // consider field-id in first position + end of string //
-  if (dtmp != NULL)
-  {
-     data[0] = dtmp[0];
-     delete[] dtmp;
-  }
-  if (len > 0)
-     memcpy(data+1, dp, len);
-  data[len+1]='\0';
+  len = 0;
+  materialize(l+1);   // consider field-id in first position //
+  data[0] = id;
+  if (l > 0)
+     memcpy(data+1, dp, l);
+  len = l+1;
 }
 
 
 int SubField::getLength()
 {
-   return strlen(data); // id + data //
+   return len; // id + data //
 }
 
 
-void SubField::print(std::ostream &os)
+void SubField::print(OutSink &os)
 {
-    os << id << ": "  << data+1 << '\n';
+    os.put(id);
+    os.write(": ", 2);
+    if (len > 1)
+       os.write(data+1, len-1);
+    os.put('\n');
 }
 
 
-void SubField::printXML(std::ostream &os, int indent)
+void SubField::printXML(OutSink &os, int indent)
 {
-    char *cp;
-    char space[] = "                                        "; // 40 spaces //
     int spc = (indent >= 40) ? 40 : indent;
     if (spc < 0) spc = 0;
-    os.write(space,spc);
-    os << "<sf c=\"" << id << "\">";
-    cp = data+1;
-    while (*cp)
-    {
-       switch(*cp)
-       {
-          case '<': os << "&lt;"; break;
-          case '>': os << "&gt;"; break;
-          case '&': os << "&amp;"; break;
-          default :  os.put(*cp);
-       }
-       ++cp;
-    }
-    os << "</sf>";
-    if (spc > 0) os << '\n';
+    os.spaces(spc);
+    os.write("<sf c=\"", 7);
+    os.putAttr(id);
+    os.write("\">", 2);
+    if (len > 1)
+       os.writeXML(data+1, len-1);
+    os.write("</sf>", 5);
+    if (spc > 0) os.put('\n');
 }
 
 
+//---------------------------------------------------------------------------------
+// deleteControlCharacters()
+//
+// i dati vengono copiati solo se contengono effettivamente caratteri < 32
+//---------------------------------------------------------------------------------
+
 void SubField::deleteControlCharacters()
 {
-   strutils::deleteControlCharacters(data);
+   if (! strutils::hasControlCharacters(data, len))
+      return;
+   if (! owned)
+      materialize(len);
+   len = strutils::deleteControlCharacters(data, len);
+   data[len] = '\0';
 }
 
-
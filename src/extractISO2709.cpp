@@ -26,10 +26,23 @@
  **************************************************************************/
 
 #include      <iostream>
-#include      <fstream>
+#include      <string>
+#include      <vector>
+#include      <cstdio>
 #include      <cstdlib>
+#include      <cstring>
+#include      <cerrno>
+#include      <fcntl.h>
+#include      <unistd.h>
+#include      <thread>
 
 #include      "RecordIso2709.h"
+#include      "Pipeline.h"
+#include      "RecordIndex.h"
+#include      "Compressor.h"
+#include      "FileSplitter.h"
+#include      "RunStats.h"
+#include      "Progress.h"
 
 
 #define  PROGRAMNAME "extractISO2709"
@@ -41,9 +54,6 @@
 using namespace std;
 
 
-long	reccount = 0L;
-const char* scartout = SCARTATI;
-
 void printVersion()
 {
     std::cout << PROGRAMNAME << " " << VERSION << "\n"
@@ -59,60 +69,95 @@ void help()
     std::cout << "\n";
     printVersion();
     std::cout << "\n";
-    std::cout << "usage:   extractISO2709 [-h] [-V] [-t] [-k] [-x] [-i indent] [input-file] [output-file]\n\n"
+    std::cout << "usage:   extractISO2709 [-h] [-V] [-t] [-k] [-x] [-i indent] [-f fields] [-j threads [-u]] [-z gzip|zstd] [--stats[=json]] [--progress-interval sec] [input-file] [output-file]\n\n"
               << "\t-h : print this help message\n"
               << "\t-V : print version\n"
               << "\t-t : output as text\n"
               << "\t-k : do not output control characters [0x00 - 0x1F]\n"
               << "\t-x : output as XML (unimarcslim)\n"
-              << "\t-i : indent XML output by 'indent' white spaces\n\n"
+              << "\t-i : indent XML output by 'indent' white spaces\n"
+              << "\t-f : output only 'fields', e.g. 001,200a,7XX (a tag, optionally followed by\n"
+              << "\t     the subfield codes to keep; X matches any digit)\n"
+              << "\t-j : convert records with 'threads' parallel workers\n"
+              << "\t-u : with -j, write records as soon as they are converted (input order is not kept)\n"
+              << "\t-z : compress output-file as gzip (or zstd, if supported by the build)\n"
+              << "\t--build-index : write the record index of input-file (input-file.idx) and exit\n"
+              << "\t--index file  : index to build or use instead of input-file.idx\n"
+              << "\t--records list: convert only the records in 'list', e.g. 1,5,10-20 (needs the index)\n"
+              << "\t--ids list    : convert only the records whose 001 is in 'list' (needs the index);\n"
+              << "\t                the exit status is 1 if a requested record is not found\n"
+              << "\t--shard i/N   : convert only the i-th of N byte ranges of input-file (1 <= i <= N);\n"
+              << "\t                the outputs of shards 1..N concatenated equal the whole output\n"
+              << "\t--zthreads n  : with -z, compress with 'n' threads (default: one per CPU)\n"
+              << "\t--stats[=json]: at the end print to standard error the time of each phase (read,\n"
+              << "\t                parse, serialize, write), bytes in and out, records/s, the record\n"
+              << "\t                length and field count histograms and the bad records by status\n"
+              << "\t--progress-interval sec : every 'sec' seconds print records, input offset, percent,\n"
+              << "\t                throughput, ETA and bad record rate to standard error\n"
+              << "\t--progress-file file : write them instead to 'file' as Prometheus metrics (node\n"
+              << "\t                exporter textfile collector; default interval 10 seconds)\n"
+              << "\t--out fmt:file: write the records to 'file' as 'fmt' (xml, iso or text); may be\n"
+              << "\t                repeated, each record is read once for all the outputs\n"
+              << "\t--where rule  : only the records matching 'rule' go to the preceding --out; rule is a\n"
+              << "\t                comma separated list of labelN=CHARS (label position N is one of\n"
+              << "\t                CHARS), has=TAG and !has=TAG, e.g. --where label7=m,has=700\n"
+              << "\t--split-records n, --split-bytes size : write each output to numbered files\n"
+              << "\t                (out.xml -> out-00001.xml, ...) of at most 'n' records or about 'size'\n"
+              << "\t                bytes (e.g. 100m), listed in out.xml.manifest\n\n"
               << "\tif output-file is not specified, output will be written to standard out\n"
-              << "\tif input-file is not specified, output will be read from standard input\n\n";
+              << "\tif input-file is not specified, output will be read from standard input\n"
+              << "\tinput-file may be compressed with gzip (or zstd, if supported by the build)\n\n";
 }
 
 
 
-void error(int errt , const char* errmsg)
-{
-   switch(errt)
-   {
-      case 1: fprintf(stderr, "%s\n[%d] record number: %ld\n",errmsg, errt, reccount);
-              break;
-
-      case 2: fprintf(stderr, "%s\n[%d]\n",errmsg, errt);
-              break;
-   }
-}
-
+//---------------------------------------------------------------------------
+// parseRecordList(): "1,5,10-20" -> ordinals 0, 4, 9..19
 
-void fatal( int errt , const char* errmsg )
+int parseRecordList( const char *spec, std::vector<long> &recs )
 {
-   switch( errt )
+   const char *cp = spec;
+   while (*cp)
    {
-      case 1: fprintf(stderr, "%s\n[%d] record number: %ld\n",errmsg, errt, reccount);
-              break;
-
-      case 2: fprintf(stderr, "%s\n[%d]\n",errmsg, errt);
-              break;
+      char *ep;
+      long from = strtol(cp, &ep, 10);
+      long to   = from;
+      if ((ep == cp) || (from < 1))
+         return 0;
+      if (*ep == '-')
+      {
+         cp = ep + 1;
+         to = strtol(cp, &ep, 10);
+         if ((ep == cp) || (to < from))
+            return 0;
+      }
+      for (long n = from ; n <= to ; ++n)
+         recs.push_back(n - 1);
+      if (*ep == ',')
+         ++ep;
+      else
+      if (*ep != '\0')
+         return 0;
+      cp = ep;
    }
-   exit(-1);
+   return 1;
 }
 
 
-void printXmlHeader( std::ostream *fout )
+void printXmlHeader( OutSink *fout )
 {
-  *fout << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
-  << "<collection xmlns=\"http://www.bncf.firenze.sbn.it/unimarc/slim\" "
-  << "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
-  << "xsi:schemaLocation=\"http://www.bncf.firenze.sbn.it/unimarc/slim http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd\""
-  << ">\n";
+  fout->puts("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+  "<collection xmlns=\"http://www.bncf.firenze.sbn.it/unimarc/slim\" "
+  "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+  "xsi:schemaLocation=\"http://www.bncf.firenze.sbn.it/unimarc/slim http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd\""
+  ">\n");
   //<< "xmlns=\"http://www.bncf.firenze.sbn.it/unimarc/slim\">"
 }
 
 
-void printXmlFooter( std::ostream *fout )
+void printXmlFooter( OutSink *fout )
 {
-    *fout << "</collection>\n";
+    fout->puts("</collection>\n");
 }
 
 
@@ -128,13 +173,36 @@ int main(int argc, char **argv)
       int      opt_print = 0;
       int      delete_controlchar = 0;
       int      opt_xml   = 0;
+      long     reccount = 0L;
       int      goodrecs = 0;
       int      badrecs = 0;
+      int      notfound = 0;   // --records, --ids: requested but missing //
       int      indent = 0;
-      char     *outputFilename;
-
-      std::ostream *fout = &std::cout;
-      std::ifstream finp;
+      int      nthreads = 0;
+      int      ordered = 1;
+      const char *outputFilename;
+      std::vector<OutputRoute> routes;   // --out //
+      FieldFilter   filter;
+      int      buildindex = 0;
+      const char *indexFilename = NULL;
+      const char *recordList = NULL;
+      const char *idList = NULL;
+      std::string   indexpath;
+      int      zformat = Compressor::NONE;
+      int      zthreads = std::thread::hardware_concurrency();
+      long     splitrecs = 0;
+      long     splitbytes = 0;
+      int      shard = 0;
+      int      nshards = 0;
+      int      statsmode = 0;   // --stats: 1 text, 2 JSON //
+      RunStats *stats = NULL;
+      double   progressival = 0;
+      const char *progressFilename = NULL;
+      Progress *progress = NULL;
+
+      const char *scartout = SCARTATI;
+      int      scartfd;
+      RecordReader  mapinp;
 
 
    // process command line options //
@@ -147,6 +215,50 @@ int main(int argc, char **argv)
                   indent = atoi(++argv[cnt]) - 1;
                   if (indent < 0) indent = 0;
                   break;
+        case 'j':
+                  // parallel conversion: -jN or -j N //
+                  if (*(argv[cnt]+1) != '\0')
+                     nthreads = atoi(++argv[cnt]);
+                  else
+                  if (argv[cnt+1] != NULL)
+                     nthreads = atoi(argv[++cnt]);
+                  break;
+        case 'f':
+                  // field projection: -fSPEC or -f SPEC //
+                  {
+                     char *spec = NULL;
+                     if (*(argv[cnt]+1) != '\0')
+                        spec = ++argv[cnt];
+                     else
+                     if (argv[cnt+1] != NULL)
+                        spec = argv[++cnt];
+                     if (spec == NULL || ! filter.parse(spec))
+                     {
+                        std::cerr << "\n\nERROR: invalid field list  " << (spec ? spec : "") << '\n';
+                        exit(2);
+                     }
+                  }
+                  break;
+        case 'z':
+                  // compressed output: -zFORMAT or -z FORMAT //
+                  {
+                     char *name = NULL;
+                     if (*(argv[cnt]+1) != '\0')
+                        name = ++argv[cnt];
+                     else
+                     if (argv[cnt+1] != NULL)
+                        name = argv[++cnt];
+                     if ((name == NULL) || ((zformat = Compressor::parseFormat(name)) == Compressor::NONE))
+                     {
+                        std::cerr << "\n\nERROR: invalid compression  " << (name ? name : "") << " (gzip or zstd)\n";
+                        exit(2);
+                     }
+                  }
+                  break;
+        case 'u':
+                  // unordered output, only with -j //
+                  ordered = 0;
+                  break;
         case 'k':
                   // delete control characters from data (0x00 - 0x31)
                   delete_controlchar = 1;
@@ -164,6 +276,104 @@ int main(int argc, char **argv)
         case 'V':
                   printVersion();
                   exit(0);
+        case '-':
+                  // long options: random access through the record index //
+                  if (strcmp(argv[cnt], "-build-index") == 0)
+                     buildindex = 1;
+                  else
+                  if ((strcmp(argv[cnt], "-index") == 0) && (argv[cnt+1] != NULL))
+                     indexFilename = argv[++cnt];
+                  else
+                  if ((strcmp(argv[cnt], "-records") == 0) && (argv[cnt+1] != NULL))
+                     recordList = argv[++cnt];
+                  else
+                  if ((strcmp(argv[cnt], "-ids") == 0) && (argv[cnt+1] != NULL))
+                     idList = argv[++cnt];
+                  else
+                  if ((strcmp(argv[cnt], "-out") == 0) && (argv[cnt+1] != NULL))
+                  {
+                     // format:file //
+                     char *sp = strchr(argv[++cnt], ':');
+                     int  fmt = -1;
+                     if (sp != NULL)
+                     {
+                        *sp = '\0';
+                        fmt = OutputRoute::parseFormat(argv[cnt]);
+                        *sp = ':';
+                     }
+                     if ((fmt < 0) || (sp[1] == '\0'))
+                     {
+                        std::cerr << "\n\nERROR: invalid output  " << argv[cnt] << " (xml:file, iso:file or text:file)\n";
+                        exit(2);
+                     }
+                     routes.push_back(OutputRoute(fmt, sp + 1));
+                  }
+                  else
+                  if ((strcmp(argv[cnt], "-where") == 0) && (argv[cnt+1] != NULL))
+                  {
+                     ++cnt;
+                     if (routes.empty() || ! routes.back().parseRule(argv[cnt]))
+                     {
+                        std::cerr << "\n\nERROR: invalid rule  " << argv[cnt] << " (after --out: labelN=CHARS, has=TAG, !has=TAG)\n";
+                        exit(2);
+                     }
+                  }
+                  else
+                  if ((strcmp(argv[cnt], "-split-records") == 0) && (argv[cnt+1] != NULL))
+                  {
+                     if ((splitrecs = atol(argv[++cnt])) <= 0)
+                     {
+                        std::cerr << "\n\nERROR: invalid number of records  " << argv[cnt] << '\n';
+                        exit(2);
+                     }
+                  }
+                  else
+                  if ((strcmp(argv[cnt], "-split-bytes") == 0) && (argv[cnt+1] != NULL))
+                  {
+                     if ((splitbytes = FileSplitter::parseSize(argv[++cnt])) <= 0)
+                     {
+                        std::cerr << "\n\nERROR: invalid size  " << argv[cnt] << " (e.g. 500000, 64k, 100m, 2g)\n";
+                        exit(2);
+                     }
+                  }
+                  else
+                  if ((strcmp(argv[cnt], "-progress-interval") == 0) && (argv[cnt+1] != NULL))
+                  {
+                     if ((progressival = atof(argv[++cnt])) <= 0)
+                     {
+                        std::cerr << "\n\nERROR: invalid interval  " << argv[cnt] << " (seconds)\n";
+                        exit(2);
+                     }
+                  }
+                  else
+                  if ((strcmp(argv[cnt], "-progress-file") == 0) && (argv[cnt+1] != NULL))
+                     progressFilename = argv[++cnt];
+                  else
+                  if (strcmp(argv[cnt], "-stats") == 0)
+                     statsmode = 1;
+                  else
+                  if (strcmp(argv[cnt], "-stats=json") == 0)
+                     statsmode = 2;
+                  else
+                  if ((strcmp(argv[cnt], "-zthreads") == 0) && (argv[cnt+1] != NULL))
+                     zthreads = atoi(argv[++cnt]);
+                  else
+                  if ((strcmp(argv[cnt], "-shard") == 0) && (argv[cnt+1] != NULL))
+                  {
+                     char c;
+                     if ((sscanf(argv[++cnt], "%d/%d%c", &shard, &nshards, &c) != 2)
+                         || (nshards < 1) || (shard < 1) || (shard > nshards))
+                     {
+                        std::cerr << "\n\nERROR: invalid shard  " << argv[cnt] << " (expected i/N)\n";
+                        exit(2);
+                     }
+                  }
+                  else
+                  {
+                     help();
+                     exit(2);
+                  }
+                  break;
         default:  
                   // invalid options
                   help();
@@ -172,97 +382,348 @@ int main(int argc, char **argv)
       ++cnt;
    }
 
+   if (statsmode)
+      stats = new RunStats();
 
 
    // open input //
    if (argv[cnt] != NULL)
    {
-      finp.open ( argv[cnt] );
-
-      if (! finp.is_open() ) 
+      // regular files are memory mapped; compressed files, pipes and //
+      // devices are read (and decompressed) by a read-ahead thread //
+      if (! mapinp.open( argv[cnt] ))
+      {
+         std::cerr << "\n\nERROR: opening input-file  " << argv[cnt];
+         if (mapinp.getError() != NULL)
+            std::cerr << ": " << mapinp.getError();
+         std::cerr << '\n';
+         exit(1);
+      }
+   }
+   else
+      mapinp.openStream(0);   // standard input, through the read-ahead thread //
+   if (buildindex || recordList || idList)
+   {
+      if (! mapinp.isMapped())
+      {
+         std::cerr << "\n\nERROR: the record index needs a regular, uncompressed input-file\n";
+         exit(1);
+      }
+      indexpath = (indexFilename != NULL) ? std::string(indexFilename)
+                                          : std::string(argv[cnt]) + ".idx";
+   }
+   if (nshards > 0)
+   {
+      if (! mapinp.isMapped() || recordList || idList || buildindex)
       {
-         std::cerr << "\n\nERROR: opening input-file  " << argv[cnt] << '\n';
+         std::cerr << "\n\nERROR: --shard needs a regular, uncompressed input-file, no record selection and no --build-index\n";
          exit(1);
       }
+      mapinp.setShard(shard - 1, nshards);
    }
    ++cnt;
 
+   if (buildindex)
+   {
+      long n = RecordIndex::build(mapinp, indexpath.c_str());
+      if (n < 0)
+      {
+         std::cerr << "\n\nERROR: writing index-file  " << indexpath << '\n';
+         exit(1);
+      }
+      std::cerr << "indexed records: " << n << "  index: " << indexpath << '\n';
+      return(0);
+   }
+
+   // records selected through the index, in the requested order //
+   RecordIndex index;
+   std::vector<long> selected;
+   if (recordList || idList)
+   {
+      if (! index.open(indexpath.c_str()))
+      {
+         std::cerr << "\n\nERROR: missing or invalid index-file  " << indexpath
+                   << " (create it with --build-index)\n";
+         exit(1);
+      }
+      if (index.isStale(mapinp))
+      {
+         std::cerr << "\n\nERROR: index-file  " << indexpath
+                   << " does not match the input-file, rebuild it with --build-index\n";
+         exit(1);
+      }
+      if (recordList && ! parseRecordList(recordList, selected))
+      {
+         std::cerr << "\n\nERROR: invalid record list  " << recordList << '\n';
+         exit(2);
+      }
+      if (idList)
+      {
+         std::string ids(idList);
+         size_t p = 0;
+         while (p <= ids.size())
+         {
+            size_t e = ids.find(',', p);
+            if (e == std::string::npos)
+               e = ids.size();
+            std::string id = ids.substr(p, e - p);
+            if (! id.empty() && (index.findId(id.c_str(), selected) == 0))
+            {
+               std::cerr << "record not found: 001 " << id << '\n';
+               ++notfound;
+            }
+            p = e + 1;
+         }
+      }
+   }
+
+   // outputs: the output-file (or standard out) in the -t/-x format, or the --out list //
+   if (routes.empty())
+   {
+      int fmt = opt_print ? OutputRoute::TEXT : opt_xml ? OutputRoute::XML : OutputRoute::ISO;
+      routes.push_back(OutputRoute(fmt, (cnt < argc) ? argv[cnt] : NULL));
+   }
+   else
+   if (cnt < argc)
+   {
+      std::cerr << "\n\nERROR: give either output-file or --out\n";
+      exit(2);
+   }
+
    // open output //
-   std::ofstream outfs;
-   if ( cnt < argc )
+   std::vector<OutSink*> outs;
+   std::vector<Compressor*> zouts;
+   std::vector<FileSplitter*> splitters;
+   for (size_t j = 0 ; j < routes.size() ; ++j)
    {
-     outputFilename = argv[cnt];
-     outfs.open(outputFilename,std::ios::binary);
-     if (outfs.is_open())
-        fout = &outfs;
-     else
+     int outfd = 1;   // standard output //
+     outputFilename = routes[j].getPath();
+     if ((splitrecs > 0) || (splitbytes > 0))
+     {
+        // rolling files: each one a complete collection //
+        if (outputFilename == NULL)
+        {
+           std::cerr << "\n\nERROR: --split-records and --split-bytes need an output-file\n";
+           exit(2);
+        }
+        FileSplitter *fs = new FileSplitter(outputFilename, splitrecs, splitbytes);
+        if (routes[j].getFormat() == OutputRoute::XML)
+           fs->setDecoration(printXmlHeader, printXmlFooter);
+        fs->setCompression(zformat, zthreads);
+        OutSink *os = fs->open();
+        if (os == NULL)
+        {
+           std::cerr << "\n\nERROR: opening output-file  " << outputFilename << ": " << strerror(fs->getError()) << '\n';
+           exit(1);
+        }
+        os->setStats(stats);
+        outs.push_back(os);
+        zouts.push_back(NULL);
+        splitters.push_back(fs);
+        continue;
+     }
+     splitters.push_back(NULL);
+     zouts.push_back(NULL);
+     if (outputFilename != NULL)
      {
-        std::cerr << "\n\nERROR: opening output-file  " << outputFilename << '\n';
-        exit(1);
+        outfd = open(outputFilename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (outfd < 0)
+        {
+           std::cerr << "\n\nERROR: opening output-file  " << outputFilename << '\n';
+           exit(1);
+        }
+     }
+     outs.push_back(new OutSink(outfd));
+     outs.back()->setStats(stats);
+     if (zformat != Compressor::NONE)
+     {
+        Compressor *zout = new Compressor();
+        if (! zout->open(outfd, zformat, zthreads))
+        {
+           std::cerr << "\n\nERROR: compression format not supported by this build\n";
+           exit(1);
+        }
+        outs.back()->setCompressor(zout);
+        zouts.back() = zout;
      }
    }
 
    // open log scartati //
-   std::ofstream scart(scartout);
-   if (! scart) 
+   scartfd = open(scartout, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (scartfd < 0)
    {
       std::cerr << "\n\nERROR: opening output-file  " << scartout << '\n';
       exit(1);
    }
 
 
+   OutSink scart(scartfd);
+
    // loop over input file //
    RecordIso2709 recordiso;
-   if (opt_xml)
-      printXmlHeader(fout);
+   // with --shard only the first and the last shard write the collection element //
+   for (size_t j = 0 ; j < routes.size() ; ++j)
+      if ((routes[j].getFormat() == OutputRoute::XML) && (shard <= 1) && (splitters[j] == NULL))
+         printXmlHeader(outs[j]);
 
-   if (finp.is_open())
-      recordiso.setInputStream(finp);
+   if (mapinp.isOpen())
+      recordiso.setInputReader(mapinp);
    else
       recordiso.setInputStream(std::cin);
 
-   while (recordiso.read())
+   // periodic report: percent done and ETA only for a mapped input-file //
+   if ((progressival > 0) || (progressFilename != NULL))
    {
-     int ok = 1;
-
-      if (recordiso.getStatus() != RecordIso2709::OK) 
+      progress = new Progress(progressival, stderr, progressFilename);
+      if (mapinp.isMapped() && ! (recordList || idList))
       {
-         ok = 0;
-         std::cerr << "status: " <<  recordiso.getStatus() << '\n';
+         long size = mapinp.getSize();
+         if (nshards > 0)
+            progress->setRange((size / nshards) * (shard - 1),
+                               (shard < nshards) ? (size / nshards) * shard : size);
+         else
+            progress->setRange(0, size);
       }
+      progress->start();
+   }
 
-      if (ok)
+   ConvertOptions opts;
+   opts.routes = routes;
+   opts.indent = indent;
+   opts.delctl = delete_controlchar;
+   opts.filter = filter.isEmpty() ? NULL : &filter;
+   recordiso.setFieldFilter(opts.filter);
+   recordiso.setStats(stats);
+
+   if (recordList || idList)
+   {
+      for (size_t j = 0 ; j < selected.size() ; ++j)
       {
-          if (delete_controlchar)
-          {
-             // delete chars 0x00 - 0x31 from data //
-             recordiso.deleteControlCharacters();
-          }
-
-          if (opt_print)
-             recordiso.print(*fout);
-          else
-          if (opt_xml)
-               recordiso.printXML(*fout,indent);
-          else
-             recordiso.write_iso(*fout);
-          ++goodrecs;
+         long offs = index.getOffset(selected[j]);
+         if (offs < 0)
+         {
+            std::cerr << "record not found: " << selected[j] + 1 << '\n';
+            ++notfound;
+            continue;
+         }
+         if (! mapinp.seek(offs))
+         {
+            std::cerr << "\n\nERROR: index-file  " << indexpath
+                      << " gives an offset outside the input-file, rebuild it with --build-index\n";
+            exit(1);
+         }
+         reccount = selected[j] + 1;   // error messages report the record number //
+         if (! recordiso.read())
+         {
+            std::cerr << recordiso.getMessages();
+            ++notfound;
+            continue;
+         }
+         RunStats::Stamp st;
+         if (stats != NULL)
+            stats->start(st);
+         if (convertRecord(recordiso, opts, outs, scart, std::cerr, reccount))
+            ++goodrecs;
+         else
+            ++badrecs;
+         if (stats != NULL)
+            stats->stop(RunStats::SERIALIZE, st);
+         if (progress != NULL)
+            progress->update(goodrecs + badrecs, badrecs);
       }
+      reccount = goodrecs + badrecs;
+   }
+   else
+   if (nthreads > 0)
+   {
+      Pipeline pipeline(nthreads, ordered);
+      pipeline.setStats(stats);
+      pipeline.setProgress(progress);
+      pipeline.run(recordiso, opts, outs, scart, std::cerr);
+      reccount = pipeline.getTotal();
+      goodrecs = pipeline.getGood();
+      badrecs  = pipeline.getBad();
+   }
+   else
+   while (recordiso.read())
+   {
+      RunStats::Stamp st;
+      if (stats != NULL)
+         stats->start(st);
+      if (convertRecord(recordiso, opts, outs, scart, std::cerr, reccount + 1))
+         ++goodrecs;
       else
-      {
          ++badrecs;
-         recordiso.print(scart); // records scartati in user readable format //
-         scart << '\n';
-      }
+      if (stats != NULL)
+         stats->stop(RunStats::SERIALIZE, st);
       ++reccount;
+      if (progress != NULL)
+      {
+         progress->update(reccount, badrecs);
+         progress->setOffset(recordiso.tell());
+      }
    }
 
-   if (opt_xml)
-      printXmlFooter(fout);
+   if (! (recordList || idList))
+      std::cerr << recordiso.getMessages();   // end of the input //
+   if (mapinp.finish() != NULL)
+   {
+      std::cerr << "\n\nERROR: reading input-file: " << mapinp.getError() << '\n';
+      exit(1);
+   }
+
+   int e = 0;
+   for (size_t j = 0 ; j < routes.size() ; ++j)
+   {
+      if (splitters[j] != NULL)
+      {
+         // last file and manifest; the splitter owns the sink //
+         if (! splitters[j]->close() && (e == 0))
+            e = splitters[j]->getError();
+         delete splitters[j];
+         continue;
+      }
+      if ((routes[j].getFormat() == OutputRoute::XML) && (shard == nshards))
+         printXmlFooter(outs[j]);
+      if (! outs[j]->flush() && (e == 0))
+         e = outs[j]->getError();
+      if ((zouts[j] != NULL) && ! zouts[j]->finish() && (e == 0))
+         e = zouts[j]->getError();
+      delete outs[j];
+      delete zouts[j];
+   }
+   if (! scart.flush() && (e == 0))
+      e = scart.getError();
+   if (e != 0)
+   {
+      std::cerr << "\n\nERROR: writing output: " << strerror(e) << '\n';
+      exit(1);
+   }
+   if (progress != NULL)
+   {
+      progress->update(reccount, badrecs);
+      progress->stop();   // final metrics //
+      delete progress;
+   }
 
    std::cerr << "total records: " << reccount
 		<< "  good: " << dec <<  goodrecs
 		<< "   bad: " << badrecs << '\n';
+   if (stats != NULL)
+   {
+      stats->addMallocs(recordiso.getMallocCount(), recordiso.getAllocCount());
+      stats->setCounts(reccount, goodrecs, badrecs);
+      if (statsmode == 2)
+         stats->printJSON(stderr);
+      else
+         stats->print(stderr);
+      delete stats;
+   }
+   if (notfound > 0)
+   {
+      std::cerr << "\n\nERROR: " << notfound << " requested records not found\n";
+      exit(1);
+   }
    return(0);
    
 }//main//
@@ -0,0 +1,342 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include        <cstring>
+#include        <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include        <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+#include "scanutils.h"
+
+
+#define S_RT	29	/* record terminator  */
+#define S_FT	30	/* field terminator   */
+#define S_SF	31	/* subfield delimiter */
+
+
+namespace scanutils
+{
+
+typedef long (*scanfn)( char* , long , std::vector<char*>& );
+typedef char* (*findfn)( char* , long , char );
+typedef long (*xmlfn)( const char* , long , char );
+
+
+//---------------------------------------------------------------------------------
+// versione scalare: usata per le code dei blocchi e se la CPU non ha SIMD
+//---------------------------------------------------------------------------------
+
+static long scanScalar( char *src , long len , std::vector<char*> &pos )
+{
+  for (long j = 0 ; j < len ; ++j)
+  {
+     unsigned char c = (unsigned char) src[j];
+     if ((c >= S_RT) && (c <= S_SF))
+     {
+        pos.push_back(src + j);
+        if (c == S_RT)
+           return j + 1;
+     }
+  }
+  return len;
+}
+
+
+static char * findScalar( char *src , long len , char c )
+{
+  return (char*) memchr(src, c, len);
+}
+
+
+// q: '"' for attribute values, '&' (already searched) for text //
+static long xmlScalar( const char *src , long len , char q )
+{
+  for (long j = 0 ; j < len ; ++j)
+  {
+     char c = src[j];
+     if ((c == '&') || (c == '<') || (c == '>') || (c == q))
+        return j;
+  }
+  return len;
+}
+
+
+#ifdef SCAN_X86
+
+// append the positions flagged in 'mask'; returns offset after RT or -1 //
+static inline long collect( char *blk , unsigned int mask , long offs ,
+			    std::vector<char*> &pos )
+{
+  while (mask)
+  {
+     int b = __builtin_ctz(mask);
+     pos.push_back(blk + b);
+     if (blk[b] == S_RT)
+        return offs + b + 1;
+     mask &= mask - 1;
+  }
+  return -1;
+}
+
+
+static long scanSSE2( char *src , long len , std::vector<char*> &pos )
+{
+  const __m128i rt = _mm_set1_epi8(S_RT);
+  const __m128i ft = _mm_set1_epi8(S_FT);
+  const __m128i sf = _mm_set1_epi8(S_SF);
+  long j = 0;
+
+  for ( ; j + 16 <= len ; j += 16)
+  {
+     __m128i v = _mm_loadu_si128((const __m128i*)(src + j));
+     __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, rt),
+					   _mm_cmpeq_epi8(v, ft)),
+			      _mm_cmpeq_epi8(v, sf));
+     unsigned int mask = _mm_movemask_epi8(m);
+     if (mask)
+     {
+        long end = collect(src + j, mask, j, pos);
+        if (end >= 0)
+           return end;
+     }
+  }
+  return j + scanScalar(src + j, len - j, pos);
+}
+
+
+static char * findSSE2( char *src , long len , char c )
+{
+  const __m128i cv = _mm_set1_epi8(c);
+  long j = 0;
+
+  for ( ; j + 16 <= len ; j += 16)
+  {
+     __m128i v = _mm_loadu_si128((const __m128i*)(src + j));
+     unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, cv));
+     if (mask)
+        return src + j + __builtin_ctz(mask);
+  }
+  return findScalar(src + j, len - j, c);
+}
+
+
+static long xmlSSE2( const char *src , long len , char q )
+{
+  const __m128i amp = _mm_set1_epi8('&');
+  const __m128i lt  = _mm_set1_epi8('<');
+  const __m128i gt  = _mm_set1_epi8('>');
+  const __m128i qt  = _mm_set1_epi8(q);
+  long j = 0;
+
+  for ( ; j + 16 <= len ; j += 16)
+  {
+     __m128i v = _mm_loadu_si128((const __m128i*)(src + j));
+     __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp),
+					   _mm_cmpeq_epi8(v, lt)),
+			      _mm_or_si128(_mm_cmpeq_epi8(v, gt),
+					   _mm_cmpeq_epi8(v, qt)));
+     unsigned int mask = _mm_movemask_epi8(m);
+     if (mask)
+        return j + __builtin_ctz(mask);
+  }
+  return j + xmlScalar(src + j, len - j, q);
+}
+
+
+__attribute__((target("avx2")))
+static long scanAVX2( char *src , long len , std::vector<char*> &pos )
+{
+  const __m256i rt = _mm256_set1_epi8(S_RT);
+  const __m256i ft = _mm256_set1_epi8(S_FT);
+  const __m256i sf = _mm256_set1_epi8(S_SF);
+  long j = 0;
+
+  for ( ; j + 32 <= len ; j += 32)
+  {
+     __m256i v = _mm256_loadu_si256((const __m256i*)(src + j));
+     __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, rt),
+						 _mm256_cmpeq_epi8(v, ft)),
+				 _mm256_cmpeq_epi8(v, sf));
+     unsigned int mask = (unsigned int) _mm256_movemask_epi8(m);
+     if (mask)
+     {
+        long end = collect(src + j, mask, j, pos);
+        if (end >= 0)
+           return end;
+     }
+  }
+  return j + scanSSE2(src + j, len - j, pos);
+}
+
+
+__attribute__((target("avx2")))
+static char * findAVX2( char *src , long len , char c )
+{
+  const __m256i cv = _mm256_set1_epi8(c);
+  long j = 0;
+
+  for ( ; j + 32 <= len ; j += 32)
+  {
+     __m256i v = _mm256_loadu_si256((const __m256i*)(src + j));
+     unsigned int mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cv));
+     if (mask)
+        return src + j + __builtin_ctz(mask);
+  }
+  return findSSE2(src + j, len - j, c);
+}
+
+
+__attribute__((target("avx2")))
+static long xmlAVX2( const char *src , long len , char q )
+{
+  if (len < 32)
+     return xmlSSE2(src, len, q);
+
+  const __m256i amp = _mm256_set1_epi8('&');
+  const __m256i lt  = _mm256_set1_epi8('<');
+  const __m256i gt  = _mm256_set1_epi8('>');
+  const __m256i qt  = _mm256_set1_epi8(q);
+  long j = 0;
+
+  for ( ; j + 32 <= len ; j += 32)
+  {
+     __m256i v = _mm256_loadu_si256((const __m256i*)(src + j));
+     __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, amp),
+						 _mm256_cmpeq_epi8(v, lt)),
+				 _mm256_or_si256(_mm256_cmpeq_epi8(v, gt),
+						 _mm256_cmpeq_epi8(v, qt)));
+     unsigned int mask = (unsigned int) _mm256_movemask_epi8(m);
+     if (mask)
+        return j + __builtin_ctz(mask);
+  }
+  return j + xmlSSE2(src + j, len - j, q);
+}
+
+#endif /* SCAN_X86 */
+
+
+//---------------------------------------------------------------------------------
+// scelta dell'implementazione in base alla CPU (una sola volta, alla prima
+// chiamata: nessun costruttore statico dipende dall'ordine di inizializzazione)
+//---------------------------------------------------------------------------------
+
+struct Impl
+{
+  int    level;		// 2: avx2, 1: sse2, 0: scalar //
+  scanfn scan;
+  findfn find;
+  xmlfn  xml;
+};
+
+static Impl choose()
+{
+  Impl im = { 0, scanScalar, findScalar, xmlScalar };
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+     Impl avx2 = { 2, scanAVX2, findAVX2, xmlAVX2 };
+     im = avx2;
+  }
+  else
+  if (__builtin_cpu_supports("sse2"))
+  {
+     Impl sse2 = { 1, scanSSE2, findSSE2, xmlSSE2 };
+     im = sse2;
+  }
+#endif
+  return im;
+}
+
+// The implementation for this CPU, resolved on first use.
+static const Impl & impl()
+{
+  static const Impl im = choose();
+  return im;
+}
+
+
+//---------------------------------------------------------------------------------
+// scanDelimiters(char*, long, std::vector<char*>&)
+//
+// aggiunge a 'pos' la posizione di ogni RT, FT e SF in src[0..len) fermandosi
+// al primo RT (compreso); restituisce il numero di byte esaminati, cioe' la
+// lunghezza del record se il RT e' stato trovato, altrimenti len
+//---------------------------------------------------------------------------------
+
+long scanDelimiters( char *src , long len , std::vector<char*> &pos )
+{
+  if (len <= 0)
+     return 0;
+  return impl().scan(src, len, pos);
+}
+
+
+//---------------------------------------------------------------------------------
+// findByte(char*, long, char)
+//
+// come memchr: posizione della prima occorrenza di c in src[0..len) o NULL
+//---------------------------------------------------------------------------------
+
+char * findByte( char *src , long len , char c )
+{
+  if (len <= 0)
+     return NULL;
+  return impl().find(src, len, c);
+}
+
+
+//---------------------------------------------------------------------------------
+// findXMLSpecial(const char*, long, int)
+//
+// offset del primo carattere di src[0..len) da sostituire con una entity XML
+// ('&', '<', '>' e, se attr, anche '"'), oppure len se non ce ne sono
+//---------------------------------------------------------------------------------
+
+long findXMLSpecial( const char *src , long len , int attr )
+{
+  if (len <= 0)
+     return 0;
+  return impl().xml(src, len, attr ? '"' : '&');
+}
+
+
+const char * implementation()
+{
+  switch (impl().level)
+  {
+     case 2:  return "avx2";
+     case 1:  return "sse2";
+  }
+  return "scalar";
+}
+
+
+}//namespace//
@@ -35,13 +35,13 @@
 
 using namespace std;
 
-extern	void 	error(int , const char*);
-
 namespace strutils
 {
 
 
 
+// value of the first len characters of src (all of it if len is 0); //
+// -1 if len is too long for a long //
 long	strntolong( char *src , int len )
 {
 	char ts[21];
@@ -50,7 +50,7 @@ long	strntolong( char *src , int len )
 	  return atol(src);
 
 	if (len > 20)
-		error(1,"parameter format error");
+		return -1;
 
 	memcpy( ts , src , len );
 	ts[len] = '\0';
@@ -59,21 +59,54 @@ long	strntolong( char *src , int len )
 }
 
 
-char * longtostrn( char* offs , long lv , int len )
+//---------------------------------------------------------------------------------
+// formatDecimal(char*, long, int)
+//
+// scrive lv in dst come 'len' cifre decimali con zeri iniziali, due cifre
+// alla volta da una tabella, senza terminare con '\0'. Restituisce 0, senza
+// toccare dst, se lv e' negativo o non sta in len cifre
+//---------------------------------------------------------------------------------
+
+static const char digitpairs[] =
+	"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+	"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+static const long pow10tab[] =
+{
+	1L, 10L, 100L, 1000L, 10000L, 100000L, 1000000L, 10000000L, 100000000L,
+	1000000000L, 10000000000L, 100000000000L, 1000000000000L,
+	10000000000000L, 100000000000000L, 1000000000000000L,
+	10000000000000000L, 100000000000000000L, 1000000000000000000L
+};
+
+int formatDecimal( char *dst , long lv , int len )
 {
-	int j;
-	char cnvl[12];
-	sprintf(cnvl,"%0*ld",len,lv);
-	if (strlen(cnvl) > len)
+	if ((lv < 0) || (len <= 0))
+		return 0;
+	if ((len < (int)(sizeof(pow10tab) / sizeof(pow10tab[0]))) && (lv >= pow10tab[len]))
+		return 0;
+
+	unsigned long v = lv;
+	char *dp = dst + len;
+	while (dp - dst >= 2)
 	{
-		char msg[100];
-		sprintf(msg,"format error in call to longtostr(%ld, %d)\n",lv,len);
-		error(1,msg);
+		unsigned int r = v % 100;
+		v /= 100;
+		dp -= 2;
+		dp[0] = digitpairs[2 * r];
+		dp[1] = digitpairs[2 * r + 1];
 	}
-	else
-	   for ( j = 0 ; j < len ; ++j )
-		offs[j] = cnvl[j]; // doesn't copy the final '\0' //
-	     
+	if (dp > dst)
+		*--dp = '0' + (char)(v % 10);
+	return 1;
+}
+
+
+// as formatDecimal(); NULL, and offs untouched, if lv does not fit //
+char * longtostrn( char* offs , long lv , int len )
+{
+	if (! formatDecimal(offs, lv, len))
+		return NULL;
 	return offs;
 }
 
@@ -104,6 +137,41 @@ char * deleteControlCharacters(char* data)
 }
 
 
+//---------------------------------------------------------------------------------
+// deleteControlCharacters(char*, int)
+// hasControlCharacters(const char*, int)
+//
+// come sopra per un buffer di lunghezza nota (non terminato da '\0'):
+// restituisce la nuova lunghezza / 1 se ci sono caratteri < 32
+//---------------------------------------------------------------------------------
+
+int deleteControlCharacters(char* data, int len)
+{
+  char * rs = data;
+
+  if (data == NULL)
+     return 0;
+
+  for (int k = 0 ; k < len ; ++k)
+     if ((unsigned char) data[k] > 31)
+        *rs++ = data[k];
+
+  return rs - data;
+}
+
+
+int hasControlCharacters(const char* data, int len)
+{
+  if (data == NULL)
+     return 0;
+
+  for (int k = 0 ; k < len ; ++k)
+     if ((unsigned char) data[k] < 32)
+        return 1;
+  return 0;
+}
+
+
 //---------------------------------------------------------------------------------
 // hasIllegalCharacters(char*)
 //
@@ -126,19 +194,14 @@ int hasIllegalCharacters(char* data)
      if  (sc > 127)
      {
          if  (sc < 0xC0)
-         {
             yes = 1;
-            std::cerr << "Bad char: " << std::hex << (short) sc <<  '\n';
-         }
          else
+         if (data[k+1] != '\0')   // do not skip the terminator //
             ++k;
      }
      else
      if ((sc < 32) && (sc != 9))
-     {
         yes = 1;
-        std::cerr << "bad char: " << std::hex << sc <<  '\n';
-     }
      ++k;
   }
   return yes;
@@ -31,8 +31,11 @@
 namespace strutils
 {
  char	*longtostrn( char* offs , long lv , int len );
+ int	formatDecimal( char *dst , long lv , int len );
  long	strntolong ( char *src , int len );
  char	*deleteControlCharacters(char* data);
+ int	deleteControlCharacters(char* data, int len);
+ int	hasControlCharacters(const char* data, int len);
  int    hasIllegalCharacters(char* data);
 }
 
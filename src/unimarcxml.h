@@ -0,0 +1,70 @@
+/**************************************************************************
+ * 	extractISO2709
+ * 	Program for data extraction from files conformant to format ISO-2709.
+ * 	Output can be generated in different formats:
+ *  	1. simple text format
+ *  	2. xml according to UNIMARCXML Schema  
+ *  	<http://www.bncf.firenze.sbn.it/progetti/unimarc/slim/documentation/unimarcslim.xsd> 
+ *  	this Schema <info:srw/schema/8/unimarcxml-v0.1>  can convert UNIMARC records as specified in the MARC
+ *  	documentation including the encoding of the so called embedded fields (4XX fields)
+ *
+ *
+ * 	Copyright (C) 2011  WEBDEV <http://www.webdev.it>, BNCF <http://www.bncf.firenze.sbn.it>
+ *
+ *    	This program is free software: you can redistribute it and/or modify
+ *    	it under the terms of the GNU General Public License as published by
+ *    	the Free Software Foundation, either version 3 of the License, or
+ *    	(at your option) any later version.
+ *
+ *    	This program is distributed in the hope that it will be useful,
+ *    	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    	GNU General Public License for more details.
+ *
+ *    	You should have received a copy of the GNU General Public License
+ *    	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#ifndef _UNIMARCXML_H_
+#define _UNIMARCXML_H_
+
+/*
+ * libunimarcxml: the ISO 2709 parser and the text, XML and ISO writers of
+ * extractISO2709, as a library (make lib: libunimarcxml.a, libunimarcxml.so).
+ *
+ * The library has no process-global state and never prints or exits:
+ *  - a RecordIso2709 holds everything about the record being decoded, so
+ *    one instance per thread can parse in parallel with the others;
+ *    FieldFilter, OutputRoute and ConvertOptions are only read and may be
+ *    shared once set up;
+ *  - read()/parse() return 0 when there is no record, getStatus() gives the
+ *    RecordIso2709 status bits of a bad one and getMessages() the errors
+ *    found, one per line;
+ *  - RecordReader, Decompressor, Compressor and OutSink report failures
+ *    with their return values and getError();
+ *  - convertRecord() and Pipeline::run() write their diagnostics to the
+ *    std::ostream they are given, RunStats::print() and Progress their
+ *    reports to the FILE they are given.
+ * A RecordVisitor reads a record without building Field objects, as a
+ * sequence of events.
+ *
+ * Parsing a record held in memory, e.g. in a server thread:
+ *
+ *	RecordIso2709 rec;
+ *	OutSink xml;				// memory sink //
+ *	if (rec.parse(data, len) && (rec.getStatus() == RecordIso2709::OK))
+ *		rec.printXML(xml, 0);		// xml.getData(), xml.getLength() //
+ *	else
+ *		... rec.getStatus(), rec.getMessages() ...
+ */
+
+#include	"RecordIso2709.h"
+#include	"RecordVisitor.h"
+#include	"RecordReader.h"
+#include	"FieldFilter.h"
+#include	"OutSink.h"
+#include	"OutputRoute.h"
+#include	"RecordIndex.h"
+#include	"Pipeline.h"
+
+#endif /* _UNIMARCXML_H_ */
@@ -0,0 +1,172 @@
+#!/bin/sh
+############################################################################
+ # 	make check: converts the records in test in the ways listed below
+ # 	and compares the outputs with the files committed in test/expected,
+ # 	or with each other where the result must not depend on how the
+ # 	input is read.
+ #
+ # 	After an intended change of the output, rewrite the expected files
+ # 	with:  UPDATE=1 make check
+############################################################################
+
+TOP=`pwd`
+BIN=$TOP/extractISO2709
+DATA=$TOP/test/data.mrc
+ESC=$TOP/test/escape.mrc
+EXP=$TOP/test/expected
+TMP=`mktemp -d` || exit 1
+trap 'rm -rf $TMP' 0
+fail=0
+
+# compares file $2 with the expected file $1
+expect()
+{
+   if [ -n "$UPDATE" ] ; then
+      cp $2 $EXP/$1
+   fi
+   if cmp -s $EXP/$1 $2 ; then
+      echo "ok    $1"
+   else
+      echo "FAIL  $1" ; fail=1
+   fi
+}
+
+# checks that files $2 and $3 are equal
+same()
+{
+   if cmp -s $2 $3 ; then
+      echo "ok    $1"
+   else
+      echo "FAIL  $1" ; fail=1
+   fi
+}
+
+# -- formats, from the memory mapped file
+$BIN -x $DATA $TMP/x 2>/dev/null	; expect data-x.exp $TMP/x
+$BIN -x -i2 $DATA $TMP/xi 2>/dev/null	; expect data-xi2.exp $TMP/xi
+$BIN -t $DATA $TMP/t 2>/dev/null	; expect data-t.exp $TMP/t
+$BIN $DATA $TMP/iso 2>/dev/null		; expect data-iso.exp $TMP/iso
+$BIN -t -f 001,200a,7XX $DATA $TMP/f 2>/dev/null ; expect data-f.exp $TMP/f
+$BIN -x $ESC $TMP/esc 2>/dev/null	; expect escape-x.exp $TMP/esc
+
+# -- the same output read from a pipe
+cat $DATA | $BIN -x > $TMP/px 2>/dev/null
+same "stdin = mapped" $TMP/x $TMP/px
+
+# -- a NUL in place of a field separator is shown, not cut off
+printf '00049nam0 2200037   450 001001100000\036ESC0000003\000\035' > $TMP/nul.mrc
+$BIN -x -s $TMP/nuls $TMP/nul.mrc 2>$TMP/nule >/dev/null
+if grep -F -q "error reading field separator: ? (0)" $TMP/nule ; then
+   echo "ok    bad separator message"
+else
+   echo "FAIL  bad separator message" ; fail=1
+fi
+
+# -- compressed input and output
+gzip -c $DATA > $TMP/d.gz
+$BIN -x $TMP/d.gz $TMP/gx 2>/dev/null
+same "gzip input" $TMP/x $TMP/gx
+$BIN -x -z gzip $DATA $TMP/o.gz 2>/dev/null && gunzip -c $TMP/o.gz > $TMP/gz
+same "gzip output" $TMP/x $TMP/gz
+if $BIN -x -z zstd $DATA $TMP/o.zst 2>/dev/null && which zstd >/dev/null 2>&1 ; then
+   zstd -q -d -c $TMP/o.zst > $TMP/zx
+   same "zstd output" $TMP/x $TMP/zx
+   zstd -q -c $DATA > $TMP/d.zst && $BIN -x $TMP/d.zst $TMP/zi 2>/dev/null
+   same "zstd input" $TMP/x $TMP/zi
+else
+   echo "skip  zstd (not in this build)"
+fi
+: > $TMP/empty.mrc
+$BIN -t -z gzip $TMP/empty.mrc $TMP/e.gz 2>/dev/null
+if gzip -t $TMP/e.gz 2>/dev/null ; then
+   echo "ok    gzip output of no records"
+else
+   echo "FAIL  gzip output of no records" ; fail=1
+fi
+
+# -- parallel conversion and shards keep the input order
+i=0
+while [ $i -lt 40 ] ; do cat $DATA ; i=`expr $i + 1` ; done > $TMP/big.mrc
+$BIN -x $TMP/big.mrc $TMP/bx 2>/dev/null
+$BIN -t $TMP/big.mrc $TMP/bt 2>/dev/null
+$BIN -j4 -x $TMP/big.mrc $TMP/jx 2>/dev/null
+same "-j4 -x order" $TMP/bx $TMP/jx
+$BIN -j3 -t $TMP/big.mrc $TMP/jt 2>/dev/null
+same "-j3 -t order" $TMP/bt $TMP/jt
+for n in 1 2 3 7 ; do
+   : > $TMP/sx
+   i=1
+   while [ $i -le $n ] ; do
+      $BIN -x --shard $i/$n $TMP/big.mrc >> $TMP/sx 2>/dev/null
+      i=`expr $i + 1`
+   done
+   same "shards 1..$n" $TMP/bx $TMP/sx
+done
+
+# -- record index
+cp $DATA $TMP/d.mrc
+$BIN --build-index $TMP/d.mrc >/dev/null 2>&1
+$BIN -t --records 2,4 $TMP/d.mrc $TMP/r 2>/dev/null ; expect index-records.exp $TMP/r
+$BIN -t --ids CFI0012299,SGE0046714 $TMP/d.mrc $TMP/i 2>/dev/null ; expect index-ids.exp $TMP/i
+if $BIN -t --ids SGE0046714,NOTANID $TMP/d.mrc $TMP/n 2>/dev/null ; then
+   echo "FAIL  missing id exit status" ; fail=1
+else
+   echo "ok    missing id exit status"
+fi
+cp $TMP/d.mrc.idx $TMP/good.idx
+printf '\377\377\377\377\377\377\377\177' | dd of=$TMP/d.mrc.idx bs=1 seek=64 conv=notrunc 2>/dev/null
+if $BIN -t --records 2 $TMP/d.mrc $TMP/n 2>/dev/null ; then
+   echo "FAIL  offset outside the input" ; fail=1
+else
+   echo "ok    offset outside the input"
+fi
+cp $TMP/good.idx $TMP/d.mrc.idx
+printf 'X' | dd of=$TMP/d.mrc.idx bs=1 seek=`expr \`wc -c < $TMP/d.mrc.idx\` - 1` conv=notrunc 2>/dev/null
+$BIN -t --ids CFI0012299 $TMP/d.mrc $TMP/n 2>$TMP/e
+if grep -q "invalid index-file" $TMP/e ; then
+   echo "ok    unterminated id pool"
+else
+   echo "FAIL  unterminated id pool" ; fail=1
+fi
+cp $TMP/good.idx $TMP/d.mrc.idx
+printf '\377\377\377\177' | dd of=$TMP/d.mrc.idx bs=1 seek=100 conv=notrunc 2>/dev/null
+$BIN -t --ids CFI0012299 $TMP/d.mrc $TMP/n 2>$TMP/e
+if grep -q "invalid index-file" $TMP/e ; then
+   echo "ok    id outside the pool"
+else
+   echo "FAIL  id outside the pool" ; fail=1
+fi
+cp $TMP/good.idx $TMP/d.mrc.idx
+if $BIN --build-index --shard 1/2 $TMP/d.mrc >/dev/null 2>&1 ; then
+   echo "FAIL  --build-index with --shard" ; fail=1
+else
+   echo "ok    --build-index with --shard"
+fi
+cp $DATA $TMP/s.mrc
+touch -d 2000-01-01 $TMP/s.mrc
+$BIN --build-index $TMP/s.mrc >/dev/null 2>&1
+printf 'X' | dd of=$TMP/s.mrc bs=1 seek=30 conv=notrunc 2>/dev/null
+if $BIN -t --records 2 $TMP/s.mrc $TMP/n 2>/dev/null ; then
+   echo "FAIL  index of a changed input" ; fail=1
+else
+   echo "ok    index of a changed input"
+fi
+
+# -- routing and split outputs, written in the temporary directory
+cp $DATA $TMP/d.mrc
+cd $TMP
+$BIN --out text:a --where label7=m,has=700 --out text:b --where '!has=700' d.mrc 2>/dev/null
+expect where-a.exp a
+expect where-b.exp b
+$BIN -t -f 001 --out text:fa --where has=700 d.mrc 2>/dev/null
+expect where-f.exp fa
+$BIN --out xml:o.xml --split-records 2 d.mrc 2>/dev/null
+expect split-manifest.exp o.xml.manifest
+expect split-2.exp o-00002.xml
+cd $TOP
+
+if [ $fail != 0 ] ; then
+   echo "make check: FAILED"
+   exit 1
+fi
+echo "make check: all passed"